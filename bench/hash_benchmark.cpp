@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "src/model/hash_policy.h"
+#include "src/model/row.h"
+
+// compares row hash policies on throughput and on how well the hashes spread in a power-of-two open
+// addressing table (slot = low bits of the hash, linear probing at load factor 0.5)
+
+static constexpr std::size_t ROW_COUNT = 1 << 18;
+
+template<typename Policy, typename... GlobalSchema, std::size_t... Indices>
+std::size_t policy_row_hash(const row_data_type<GlobalSchema...>& data, std::index_sequence<Indices...>) {
+    std::array<std::size_t, sizeof...(GlobalSchema)> column_hashes = {Policy::hash_column(std::get<Indices>(data))...};
+    return combine_hashes<Policy>(column_hashes, attr_type<GlobalSchema...>().set());
+}
+
+template<typename Policy, typename... GlobalSchema>
+std::size_t policy_row_hash(const row_data_type<GlobalSchema...>& data) {
+    return policy_row_hash<Policy, GlobalSchema...>(data, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+}
+
+// sequential (x, y) pairs
+std::vector<row_data_type<int, int>> sequential_int_rows() {
+    std::vector<row_data_type<int, int>> rows;
+    for (std::size_t i = 0; i < ROW_COUNT; i++) {
+        rows.emplace_back(i / 64, i % 64);
+    }
+    return rows;
+}
+
+// heavy-hitter x values (power-law degree) with a distinct y per row
+std::vector<row_data_type<int, int>> skewed_int_rows() {
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<row_data_type<int, int>> rows;
+    for (std::size_t i = 0; i < ROW_COUNT; i++) {
+        int x = static_cast<int>(std::pow(uniform(gen), 4.0) * 1024);
+        rows.emplace_back(x, i);
+    }
+    return rows;
+}
+
+// long categorical keys sharing a common prefix
+std::vector<row_data_type<std::string, int>> string_rows() {
+    std::vector<row_data_type<std::string, int>> rows;
+    for (std::size_t i = 0; i < ROW_COUNT; i++) {
+        rows.emplace_back("customer_account_" + std::to_string(i / 16), i % 16);
+    }
+    return rows;
+}
+
+template<typename Policy, typename Row>
+void report_distribution(benchmark::State& state, const std::vector<Row>& rows) {
+    std::size_t slot_count = 1;
+    while (slot_count < 2 * rows.size()) {
+        slot_count <<= 1;
+    }
+    std::vector<bool> occupied(slot_count, false);
+    std::size_t home_collisions = 0;
+    std::size_t probes = 0;
+    for (const Row& row : rows) {
+        std::size_t slot = policy_row_hash<Policy>(row) & (slot_count - 1);
+        if (occupied[slot]) {
+            home_collisions++;
+        }
+        while (occupied[slot]) {
+            slot = (slot + 1) & (slot_count - 1);
+            probes++;
+        }
+        occupied[slot] = true;
+    }
+    state.counters["collision_rate"] = static_cast<double>(home_collisions) / rows.size();
+    state.counters["avg_extra_probes"] = static_cast<double>(probes) / rows.size();
+}
+
+template<typename Policy, typename Row>
+void run_hash_benchmark(benchmark::State& state, const std::vector<Row>& rows) {
+    for (auto _ : state) {
+        std::size_t acc = 0;
+        for (const Row& row : rows) {
+            acc ^= policy_row_hash<Policy>(row);
+        }
+        benchmark::DoNotOptimize(acc);
+    }
+    state.SetItemsProcessed(state.iterations() * rows.size());
+    report_distribution<Policy>(state, rows);
+}
+
+template<typename Policy>
+void BM_SequentialInts(benchmark::State& state) {
+    static const std::vector<row_data_type<int, int>> rows = sequential_int_rows();
+    run_hash_benchmark<Policy>(state, rows);
+}
+
+template<typename Policy>
+void BM_SkewedInts(benchmark::State& state) {
+    static const std::vector<row_data_type<int, int>> rows = skewed_int_rows();
+    run_hash_benchmark<Policy>(state, rows);
+}
+
+template<typename Policy>
+void BM_Strings(benchmark::State& state) {
+    static const std::vector<row_data_type<std::string, int>> rows = string_rows();
+    run_hash_benchmark<Policy>(state, rows);
+}
+
+BENCHMARK_TEMPLATE(BM_SequentialInts, StdHashPolicy);
+BENCHMARK_TEMPLATE(BM_SequentialInts, WyHashPolicy);
+BENCHMARK_TEMPLATE(BM_SkewedInts, StdHashPolicy);
+BENCHMARK_TEMPLATE(BM_SkewedInts, WyHashPolicy);
+BENCHMARK_TEMPLATE(BM_Strings, StdHashPolicy);
+BENCHMARK_TEMPLATE(BM_Strings, WyHashPolicy);
+
+BENCHMARK_MAIN();
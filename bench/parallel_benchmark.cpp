@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <bitset>
+#include <vector>
+
+#include "src/model/parallel_table.h"
+#include "src/model/table.h"
+#include "src/thread_pool.h"
+
+// compares the sequential operators with the morsel-driven ones (see parallel_table.h) - the argument is the
+// number of pool threads, and 0 runs the sequential operator (a pool of 1 thread also falls back to it)
+
+static constexpr std::size_t ROW_COUNT = 1 << 20;
+static constexpr std::size_t KEY_COUNT = 1 << 18;
+
+using BenchTable = Table<int, int, int>;
+
+// (x, y, z) rows with 2^18 x values, 4 y values per x and z a function of x - the projection onto xz keeps a
+// quarter of the rows, and the join of the x values with the y values of each x makes every row again
+BenchTable bench_table() {
+    BenchTable table{RowSet<int, int, int>(), std::bitset<3>("111")};
+    table.data.reserve(ROW_COUNT);
+    for (std::size_t i = 0; i < ROW_COUNT; i++) {
+        row_data_type<int, int, int> row = {(int) (i % KEY_COUNT), (int) (i / KEY_COUNT), (int) (i % 2)};
+        table.data.insert(HashableRow<int, int, int>(row, std::bitset<3>("111")));
+    }
+    return table;
+}
+
+const BenchTable& shared_bench_table() {
+    static const BenchTable table = bench_table();
+    return table;
+}
+
+void BM_Project(benchmark::State& state) {
+    const BenchTable& table = shared_bench_table();
+    std::size_t threads = state.range(0);
+    WorkStealingPool pool(threads > 0 ? threads : 1);
+    std::size_t output_rows = 0;
+    for (auto _ : state) {
+        if (threads == 0) {
+            output_rows = project(table, std::bitset<3>("101")).data.size();
+        } else {
+            output_rows = parallel_project(pool, table, std::bitset<3>("101")).data.size();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * table.data.size());
+    state.counters["output_rows"] = output_rows;
+}
+
+void BM_Join(benchmark::State& state) {
+    static const Dictionary<int, int, int> dict = construction(
+        project(shared_bench_table(), std::bitset<3>("011")), std::bitset<3>("001"), std::bitset<3>("010"));
+    static const BenchTable probe = project(shared_bench_table(), std::bitset<3>("001"));
+    std::size_t threads = state.range(0);
+    WorkStealingPool pool(threads > 0 ? threads : 1);
+    std::size_t output_rows = 0;
+    for (auto _ : state) {
+        if (threads == 0) {
+            output_rows = join(probe, dict).data.size();
+        } else {
+            output_rows = parallel_join(pool, probe, dict).data.size();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probe.data.size());
+    state.counters["output_rows"] = output_rows;
+}
+
+// union of two overlapping three-quarters of the table
+void BM_Union(benchmark::State& state) {
+    const BenchTable& table = shared_bench_table();
+    static const std::array<BenchTable, 2> parts = []() {
+        std::array<BenchTable, 2> split = {BenchTable{RowSet<int, int, int>(), std::bitset<3>("111")},
+            BenchTable{RowSet<int, int, int>(), std::bitset<3>("111")}};
+        for (const auto& row : shared_bench_table().data) {
+            int y = row.get<1>();
+            if (y != 0) {
+                split[0].data.insert(row);
+            }
+            if (y != 3) {
+                split[1].data.insert(row);
+            }
+        }
+        return split;
+    }();
+    std::size_t threads = state.range(0);
+    WorkStealingPool pool(threads > 0 ? threads : 1);
+    std::size_t output_rows = 0;
+    for (auto _ : state) {
+        if (threads == 0) {
+            BenchTable union_table{RowSet<int, int, int>(), table.attributes};
+            inplace_union(union_table, parts[0]);
+            inplace_union(union_table, parts[1]);
+            output_rows = union_table.data.size();
+        } else {
+            ShardedTable<int, int, int> union_table{ShardedRowSet<int, int, int>(shard_bits(pool)), table.attributes};
+            parallel_inplace_union(pool, union_table, parts[0]);
+            parallel_inplace_union(pool, union_table, parts[1]);
+            output_rows = union_table.data.size();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (parts[0].data.size() + parts[1].data.size()));
+    state.counters["output_rows"] = output_rows;
+}
+
+BENCHMARK(BM_Project)->Arg(0)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Join)->Arg(0)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Union)->Arg(0)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -12,6 +12,7 @@ int main(int argc, char* argv[]) {
     const struct option long_options[] = {
         {"spec_dir", required_argument, nullptr, 's'},
         {"tables_dir", required_argument, nullptr, 't'},
+        {"threads", required_argument, nullptr, 'j'},
         {nullptr, 0, nullptr, 0}
     };
 
@@ -19,7 +20,8 @@ int main(int argc, char* argv[]) {
     int long_index = 0;
     std::string spec_dir;
     std::string table_dir;
-    while ((opt = getopt_long(argc, argv, "s:t:", long_options, &long_index)) != -1) {
+    PandaOptions options;
+    while ((opt = getopt_long(argc, argv, "s:t:j:", long_options, &long_index)) != -1) {
         switch (opt) {
             case 's':
                 spec_dir = optarg;
@@ -27,8 +29,11 @@ int main(int argc, char* argv[]) {
             case 't':
                 table_dir = optarg;
                 break;
+            case 'j':
+                options.num_threads = std::stoul(optarg);
+                break;
             default:
-                std::cerr << "Usage: " << argv[0] << " [--spec_dir <spec directory>] [--tables_dir <tables directory>]" << std::endl;
+                std::cerr << "Usage: " << argv[0] << " [--spec_dir <spec directory>] [--tables_dir <tables directory>] [--threads <thread count>]" << std::endl;
                 return 1;
         }
     }
@@ -37,8 +42,8 @@ int main(int argc, char* argv[]) {
         throw std::runtime_error(err_msg);
     }
 
-    Subproblem<int, double, std::string, int> init_subproblem = parse_spec<int, double, std::string, int>(spec_dir, spec_file, table_dir);
-    std::unordered_map<Monotonicity<int, double, std::string, int>, Table<int, double, std::string, int>> output = generate_ddr_feasible_output<int, double, std::string, int>(init_subproblem);
+    Subproblem<int, double, InternedString, int> init_subproblem = parse_spec<int, double, InternedString, int>(spec_dir, spec_file, table_dir);
+    FeasibleOutput<int, double, InternedString, int> output = generate_ddr_feasible_output<int, double, InternedString, int>(init_subproblem, options);
     std::cout << "==== FEASIBLE DDR OUTPUT ====" << std::endl;
     for (const auto& [mon, table] : output) {
         print(table);
@@ -41,32 +41,38 @@ std::vector<std::vector<std::string>> load_csv(const std::string& filename) {
 
 // entry parsers - extend to support more types
 template<typename col_type>
-std::any process_entry(std::string entry);
+col_type process_entry(std::string entry);
 
 template<>
-std::any process_entry<std::string>(std::string entry) {
-    return std::any(entry);
+std::string process_entry<std::string>(std::string entry) {
+    return entry;
 }
 
+// string columns declared as InternedString are dictionary encoded at load time
 template<>
-std::any process_entry<double>(std::string entry) {
-    return std::any(std::stod(entry));
+InternedString process_entry<InternedString>(std::string entry) {
+    return InternedString(entry);
 }
 
 template<>
-std::any process_entry<int>(std::string entry) {
-    return std::any(std::stoi(entry));
+double process_entry<double>(std::string entry) {
+    return std::stod(entry);
+}
+
+template<>
+int process_entry<int>(std::string entry) {
+    return std::stoi(entry);
 }
 
 template<std::size_t index, typename... GlobalSchema>
-std::any process_row_idx(
-        const std::vector<std::string> row,
+elem_type<index, GlobalSchema...> process_row_idx(
+        const std::vector<std::string>& row,
         const attr_type<GlobalSchema...> table_attrs) {
 
     if (table_attrs[index]) {
         return process_entry<elem_type<index, GlobalSchema...>>(row[index]);
     } else {
-        return std::any();
+        return elem_type<index, GlobalSchema...>();
     }
 }
 
@@ -87,8 +93,8 @@ HashableRow<GlobalSchema...> process_row_pack(
             padded_row.push_back(std::string());
         }
     }
-    std::array<std::any, sizeof...(GlobalSchema)> parsed_row = {process_row_idx<Indices, GlobalSchema...>(padded_row, table_attrs)...};
-    return HashableRow<GlobalSchema...>(parsed_row);
+    row_data_type<GlobalSchema...> parsed_row = {process_row_idx<Indices, GlobalSchema...>(padded_row, table_attrs)...};
+    return HashableRow<GlobalSchema...>(std::move(parsed_row), table_attrs);
 }
 
 template<typename... GlobalSchema>
@@ -104,7 +110,7 @@ Table<GlobalSchema...> parse_table(
         const std::vector<std::vector<std::string>>& raw_rows,
         const attr_type<GlobalSchema...> table_attrs,
         const Dummy<GlobalSchema...> dummy) {
-    std::unordered_set<HashableRow<GlobalSchema...>> data;
+    RowSet<GlobalSchema...> data;
     for (std::size_t i = 1; i < raw_rows.size(); i++) {
         HashableRow<GlobalSchema...> parsed_row = process_row(raw_rows[i], table_attrs, dummy);
         data.insert(parsed_row);
@@ -142,7 +148,7 @@ Subproblem<GlobalSchema...> parse_spec(
 
     // Load tables + constraints and calculate global bound
     YAML::Node tables = spec["Tables"];
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> Tn_tables;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables;
     long double global_bound = 1;
     for (std::size_t i = 0; i < tables.size(); i++) {
         std::vector<std::string> table_entry = tables[i].as<std::vector<std::string>>();
@@ -176,7 +182,7 @@ Subproblem<GlobalSchema...> parse_spec(
         if (Tn_tables.count(mon) == 0) {
             Tn_tables[mon] = {};
         }
-        Tn_tables[mon].push_back(std::make_pair(table, constraint));
+        Tn_tables[mon].push_back(std::make_pair(std::move(table), constraint));
 
         // update the global bound
         global_bound *= (pow(constraint, w));
@@ -206,7 +212,7 @@ Subproblem<GlobalSchema...> parse_spec(
     }
 
     // Construct Tn_dicts (empty)
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Dictionary<GlobalSchema...>, Constraint>>> Tn_dicts;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts;
 
     // Construct M
     std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> M;
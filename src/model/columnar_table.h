@@ -0,0 +1,405 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+#include "src/model/table.h"
+#include "src/model/row.h"
+
+// columnar (struct-of-arrays) variant of Table
+// - only the columns in attributes are populated, so scans touch just the masked columns
+// - rows are deduplicated through a hash index (row hash -> first row, collisions chained through next)
+// - row hashes match the HashableRow hash of the same row
+template<typename... GlobalSchema>
+using column_data_type = std::tuple<std::vector<GlobalSchema>...>;
+
+template<typename... GlobalSchema>
+struct ColumnarTable {
+    // end of a hash chain, or a lookup that found no row
+    static constexpr uint32_t NO_ROW = std::numeric_limits<uint32_t>::max();
+
+    column_data_type<GlobalSchema...> columns;
+    std::vector<std::size_t> hashes;
+    absl::flat_hash_map<std::size_t, uint32_t> index;
+    std::vector<uint32_t> next;
+    attr_type<GlobalSchema...> attributes;
+
+    std::size_t size() const {
+        return hashes.size();
+    }
+};
+
+// filtered view - selection vector of row indices into a columnar table
+template<typename... GlobalSchema>
+struct ColumnarView {
+    const ColumnarTable<GlobalSchema...>* table;
+    std::vector<uint32_t> selection;
+
+    std::size_t size() const {
+        return selection.size();
+    }
+};
+
+// Y|X dictionary - distinct X keys with a CSR range of Y rows per key
+template<typename... GlobalSchema>
+struct ColumnarDictionary {
+    ColumnarTable<GlobalSchema...> keys;
+    std::vector<uint32_t> offsets;
+    ColumnarTable<GlobalSchema...> payload;
+    attr_type<GlobalSchema...> attributes_X;
+    attr_type<GlobalSchema...> attributes_Y;
+};
+
+// row references - anything exposing get<index>() can be hashed/compared/appended (including HashableRow)
+template<typename... GlobalSchema>
+struct ColumnarRowRef {
+    const ColumnarTable<GlobalSchema...>& table;
+    uint32_t row;
+
+    template<std::size_t index>
+    const elem_type<index, GlobalSchema...>& get() const {
+        return std::get<index>(table.columns)[row];
+    }
+};
+
+template<typename Left, typename Right, typename... GlobalSchema>
+struct JoinedRowRef {
+    const Left& left;
+    const Right& right;
+    const attr_type<GlobalSchema...>& left_attrs;
+
+    template<std::size_t index>
+    const elem_type<index, GlobalSchema...>& get() const {
+        return left_attrs[index] ? left.template get<index>() : right.template get<index>();
+    }
+};
+
+template<typename... GlobalSchema>
+ColumnarView<GlobalSchema...> full_view(const ColumnarTable<GlobalSchema...>& table) {
+    ColumnarView<GlobalSchema...> view{&table, std::vector<uint32_t>(table.size())};
+    std::iota(view.selection.begin(), view.selection.end(), 0);
+    return view;
+}
+
+// row hash
+template<std::size_t index, typename Source, typename... GlobalSchema>
+std::size_t columnar_hash_idx(const attr_type<GlobalSchema...>& attrs, const Source& source) {
+    if (attrs[index]) {
+        return row_hash_policy_t<GlobalSchema...>::hash_column(source.template get<index>());
+    } else {
+        return 0;
+    }
+}
+
+template<typename Source, typename... GlobalSchema, std::size_t... Indices>
+std::size_t columnar_hash_pack(
+        const attr_type<GlobalSchema...>& attrs,
+        const Source& source,
+        std::index_sequence<Indices...>) {
+    std::array<std::size_t, sizeof...(GlobalSchema)> seeds = {columnar_hash_idx<Indices, Source, GlobalSchema...>(attrs, source)...};
+    return combine_hashes<row_hash_policy_t<GlobalSchema...>>(seeds, attrs);
+}
+
+template<typename Source, typename... GlobalSchema>
+std::size_t columnar_hash(const attr_type<GlobalSchema...>& attrs, const Source& source) {
+    return columnar_hash_pack<Source, GlobalSchema...>(attrs, source, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+}
+
+// row equality (over the table's columns)
+template<typename Source, typename... GlobalSchema, std::size_t... Indices>
+bool columnar_eq_pack(
+        const ColumnarTable<GlobalSchema...>& table,
+        uint32_t row,
+        const Source& source,
+        std::index_sequence<Indices...>) {
+    return ((!table.attributes[Indices] || std::get<Indices>(table.columns)[row] == source.template get<Indices>()) && ...);
+}
+
+// row append (no deduplication)
+template<std::size_t index, typename Source, typename... GlobalSchema>
+void columnar_append_idx(ColumnarTable<GlobalSchema...>& table, const Source& source) {
+    if (table.attributes[index]) {
+        std::get<index>(table.columns).push_back(source.template get<index>());
+    }
+}
+
+template<typename Source, typename... GlobalSchema, std::size_t... Indices>
+void columnar_append_pack(ColumnarTable<GlobalSchema...>& table, const Source& source, std::index_sequence<Indices...>) {
+    (columnar_append_idx<Indices, Source, GlobalSchema...>(table, source), ...);
+}
+
+template<typename Source, typename... GlobalSchema>
+uint32_t columnar_append(ColumnarTable<GlobalSchema...>& table, const Source& source, std::size_t hash) {
+    columnar_append_pack<Source, GlobalSchema...>(table, source, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+    table.hashes.push_back(hash);
+    table.next.push_back(ColumnarTable<GlobalSchema...>::NO_ROW);
+    return table.size() - 1;
+}
+
+// lookup - returns the matching row or NO_ROW
+template<typename Source, typename... GlobalSchema>
+uint32_t columnar_find(const ColumnarTable<GlobalSchema...>& table, const Source& source, std::size_t hash) {
+    auto it = table.index.find(hash);
+    if (it == table.index.end()) {
+        return ColumnarTable<GlobalSchema...>::NO_ROW;
+    }
+    for (uint32_t row = it->second; row != ColumnarTable<GlobalSchema...>::NO_ROW; row = table.next[row]) {
+        if (columnar_eq_pack<Source, GlobalSchema...>(table, row, source, std::make_index_sequence<sizeof...(GlobalSchema)>{})) {
+            return row;
+        }
+    }
+    return ColumnarTable<GlobalSchema...>::NO_ROW;
+}
+
+// insert - returns the (new or existing) row and whether it was inserted
+template<typename Source, typename... GlobalSchema>
+std::pair<uint32_t, bool> columnar_insert(ColumnarTable<GlobalSchema...>& table, const Source& source, std::size_t hash) {
+    uint32_t existing = columnar_find(table, source, hash);
+    if (existing != ColumnarTable<GlobalSchema...>::NO_ROW) {
+        return std::make_pair(existing, false);
+    }
+    uint32_t row = columnar_append(table, source, hash);
+    auto [it, inserted] = table.index.try_emplace(hash, row);
+    if (!inserted) {
+        table.next[row] = it->second;
+        it->second = row;
+    }
+    return std::make_pair(row, true);
+}
+
+template<typename Source, typename... GlobalSchema>
+std::pair<uint32_t, bool> columnar_insert(ColumnarTable<GlobalSchema...>& table, const Source& source) {
+    return columnar_insert(table, source, columnar_hash<Source, GlobalSchema...>(table.attributes, source));
+}
+
+// conversion
+template<typename... GlobalSchema>
+ColumnarTable<GlobalSchema...> to_columnar(const Table<GlobalSchema...>& table) {
+    ColumnarTable<GlobalSchema...> columnar;
+    columnar.attributes = table.attributes;
+    columnar.index.reserve(table.data.size());
+    for (const HashableRow<GlobalSchema...>& row : table.data) {
+        columnar_insert(columnar, row, row.hash);
+    }
+    return columnar;
+}
+
+template<typename... GlobalSchema, std::size_t... Indices>
+HashableRow<GlobalSchema...> to_row_pack(
+        const ColumnarTable<GlobalSchema...>& table,
+        uint32_t row,
+        std::index_sequence<Indices...>) {
+    row_data_type<GlobalSchema...> data = {
+        (table.attributes[Indices] ? std::get<Indices>(table.columns)[row] : elem_type<Indices, GlobalSchema...>())...
+    };
+    return HashableRow<GlobalSchema...>(std::move(data), table.attributes);
+}
+
+template<typename... GlobalSchema>
+HashableRow<GlobalSchema...> to_row(const ColumnarTable<GlobalSchema...>& table, uint32_t row) {
+    return to_row_pack(table, row, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+}
+
+template<typename... GlobalSchema>
+Table<GlobalSchema...> to_table(const ColumnarTable<GlobalSchema...>& table) {
+    Table<GlobalSchema...> row_table;
+    row_table.attributes = table.attributes;
+    row_table.data.reserve(table.size());
+    for (uint32_t row = 0; row < table.size(); row++) {
+        row_table.data.insert(to_row(table, row));
+    }
+    return row_table;
+}
+
+template<typename... GlobalSchema>
+ColumnarTable<GlobalSchema...> materialize(const ColumnarView<GlobalSchema...>& view) {
+    ColumnarTable<GlobalSchema...> table;
+    table.attributes = view.table->attributes;
+    table.index.reserve(view.size());
+    for (uint32_t row : view.selection) {
+        columnar_insert(table, ColumnarRowRef<GlobalSchema...>{*view.table, row}, view.table->hashes[row]);
+    }
+    return table;
+}
+
+// projection
+template<typename... GlobalSchema>
+ColumnarTable<GlobalSchema...> project(
+        const ColumnarView<GlobalSchema...>& view,
+        const attr_type<GlobalSchema...>& proj_attrs) {
+    ColumnarTable<GlobalSchema...> proj_table;
+    proj_table.attributes = proj_attrs;
+    for (uint32_t row : view.selection) {
+        columnar_insert(proj_table, ColumnarRowRef<GlobalSchema...>{*view.table, row});
+    }
+    return proj_table;
+}
+
+template<typename... GlobalSchema>
+ColumnarTable<GlobalSchema...> project(
+        const ColumnarTable<GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& proj_attrs) {
+    return project(full_view(table), proj_attrs);
+}
+
+// construction
+template<typename... GlobalSchema>
+ColumnarDictionary<GlobalSchema...> construction(
+        const ColumnarView<GlobalSchema...>& view,
+        const attr_type<GlobalSchema...>& attrs_X,
+        const attr_type<GlobalSchema...>& attrs_Y) {
+    ColumnarDictionary<GlobalSchema...> dict;
+    dict.attributes_X = attrs_X;
+    dict.attributes_Y = attrs_Y;
+    dict.keys.attributes = attrs_X;
+    dict.payload.attributes = attrs_Y;
+
+    // group rows by X (touches only the X columns)
+    std::vector<uint32_t> row_keys;
+    row_keys.reserve(view.size());
+    for (uint32_t row : view.selection) {
+        row_keys.push_back(columnar_insert(dict.keys, ColumnarRowRef<GlobalSchema...>{*view.table, row}).first);
+    }
+
+    // CSR offsets from per-key counts
+    dict.offsets.assign(dict.keys.size() + 1, 0);
+    for (uint32_t key : row_keys) {
+        dict.offsets[key + 1]++;
+    }
+    std::partial_sum(dict.offsets.begin(), dict.offsets.end(), dict.offsets.begin());
+
+    // scatter rows into key order
+    std::vector<uint32_t> cursor(dict.offsets.begin(), dict.offsets.end() - 1);
+    std::vector<uint32_t> ordered_rows(view.size());
+    for (std::size_t i = 0; i < view.size(); i++) {
+        ordered_rows[cursor[row_keys[i]]++] = view.selection[i];
+    }
+
+    // copy out the Y columns key by key - rows of a table over exactly XY are distinct pairs, otherwise Y rows
+    // are deduplicated per key (payload rows of the current key are chained by hash through key_next)
+    bool distinct_pairs = view.table->attributes == (attrs_X ^ attrs_Y);
+    absl::flat_hash_map<std::size_t, uint32_t> key_index;
+    std::vector<uint32_t> key_next;
+    std::vector<uint32_t> group_offsets(dict.offsets.size(), 0);
+    for (uint32_t key = 0; key + 1 < dict.offsets.size(); key++) {
+        group_offsets[key] = dict.payload.size();
+        key_index.clear();
+        for (uint32_t i = dict.offsets[key]; i < dict.offsets[key + 1]; i++) {
+            ColumnarRowRef<GlobalSchema...> ref{*view.table, ordered_rows[i]};
+            std::size_t hash = columnar_hash<ColumnarRowRef<GlobalSchema...>, GlobalSchema...>(attrs_Y, ref);
+            if (distinct_pairs) {
+                columnar_append(dict.payload, ref, hash);
+                continue;
+            }
+            auto [it, inserted] = key_index.try_emplace(hash, ColumnarTable<GlobalSchema...>::NO_ROW);
+            bool duplicate = false;
+            for (uint32_t y = it->second; y != ColumnarTable<GlobalSchema...>::NO_ROW && !duplicate; y = key_next[y]) {
+                duplicate = columnar_eq_pack<ColumnarRowRef<GlobalSchema...>, GlobalSchema...>(
+                    dict.payload, y, ref, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+            }
+            if (!duplicate) {
+                uint32_t y = columnar_append(dict.payload, ref, hash);
+                key_next.resize(dict.payload.size(), ColumnarTable<GlobalSchema...>::NO_ROW);
+                key_next[y] = it->second;
+                it->second = y;
+            }
+        }
+    }
+    group_offsets.back() = dict.payload.size();
+    dict.offsets = std::move(group_offsets);
+    return dict;
+}
+
+template<typename... GlobalSchema>
+ColumnarDictionary<GlobalSchema...> construction(
+        const ColumnarTable<GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& attrs_X,
+        const attr_type<GlobalSchema...>& attrs_Y) {
+    return construction(full_view(table), attrs_X, attrs_Y);
+}
+
+// join
+template<typename... GlobalSchema>
+ColumnarTable<GlobalSchema...> join(
+        const ColumnarView<GlobalSchema...>& view,
+        const ColumnarDictionary<GlobalSchema...>& dictionary) {
+    ColumnarTable<GlobalSchema...> join_table;
+    join_table.attributes = dictionary.attributes_X ^ dictionary.attributes_Y;
+    for (uint32_t row : view.selection) {
+        ColumnarRowRef<GlobalSchema...> row_X{*view.table, row};
+        uint32_t key = columnar_find(dictionary.keys, row_X, columnar_hash<ColumnarRowRef<GlobalSchema...>, GlobalSchema...>(dictionary.attributes_X, row_X));
+        if (key == ColumnarTable<GlobalSchema...>::NO_ROW) {
+            continue;
+        }
+        for (uint32_t y = dictionary.offsets[key]; y < dictionary.offsets[key + 1]; y++) {
+            ColumnarRowRef<GlobalSchema...> row_Y{dictionary.payload, y};
+            JoinedRowRef<ColumnarRowRef<GlobalSchema...>, ColumnarRowRef<GlobalSchema...>, GlobalSchema...> join_row{
+                row_X, row_Y, dictionary.attributes_X
+            };
+            columnar_insert(join_table, join_row);
+        }
+    }
+    return join_table;
+}
+
+template<typename... GlobalSchema>
+ColumnarTable<GlobalSchema...> join(
+        const ColumnarTable<GlobalSchema...>& table,
+        const ColumnarDictionary<GlobalSchema...>& dictionary) {
+    return join(full_view(table), dictionary);
+}
+
+// partition - the rows of each X value are a run of row indices, assigned to partitions like the row-based
+// partition (see assign_partitions), returned as selection vectors
+struct ColumnarPartitionRun {
+    uint32_t key_X;
+    std::vector<uint32_t> rows;
+};
+
+template<typename... GlobalSchema>
+std::vector<ColumnarView<GlobalSchema...>> partition(
+        const ColumnarView<GlobalSchema...>& view,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        const PartitionStrategy& strategy = PartitionStrategy()) {
+    std::vector<ColumnarView<GlobalSchema...>> partitioned_views;
+    if (view.size() == 0) {
+        return partitioned_views;
+    }
+
+    ColumnarTable<GlobalSchema...> keys;
+    keys.attributes = partition_attrs;
+    std::vector<ColumnarPartitionRun> runs;
+    for (uint32_t row : view.selection) {
+        auto [key, inserted] = columnar_insert(keys, ColumnarRowRef<GlobalSchema...>{*view.table, row});
+        if (inserted) {
+            runs.push_back(ColumnarPartitionRun{key, {}});
+        }
+        runs[key].rows.push_back(row);
+    }
+
+    for (const auto& partition_runs : assign_partitions(std::move(runs), view.size(), strategy)) {
+        ColumnarView<GlobalSchema...> partitioned_view{view.table, {}};
+        for (const auto& run : partition_runs) {
+            partitioned_view.selection.insert(partitioned_view.selection.end(), run.rows.begin(), run.rows.end());
+        }
+        partitioned_views.push_back(std::move(partitioned_view));
+    }
+    return partitioned_views;
+}
+
+template<typename... GlobalSchema>
+std::vector<ColumnarView<GlobalSchema...>> partition(
+        const ColumnarTable<GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        const PartitionStrategy& strategy = PartitionStrategy()) {
+    return partition(full_view(table), partition_attrs, strategy);
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "src/model/row.h"
+
+// insert-only row set for outputs written by several threads at once
+// - open addressing with linear probing over an array of row pointers, keyed by the cached row hash - an insert
+//   claims an empty slot with one CAS, and a racing insert of an equal row finds the winner's row instead
+// - rows are heap allocated once and never move, so pointers to them stay valid for the lifetime of the set
+// - growth: once an array is half full its slots are frozen (empty slots are CAS'd to a marker) and its rows are
+//   copied into an array twice the size, in chunks claimed by every thread that runs into a frozen slot
+// - inserts and lookups take no locks, but growth blocks: a thread that reaches a frozen slot helps copy and then
+//   waits until every claimed chunk is copied, so a stalled helper stalls the others until it resumes
+// - old arrays are kept until the set is destroyed (at most as many slots as the final array)
+// - a moved-from set has no array, so moves never allocate - the first insert (or reserve) installs one
+// - iteration, size(), reserve() and moves are only meaningful while no insert is in flight
+template<typename... GlobalSchema>
+class ConcurrentRowSet {
+public:
+    using row_type = HashableRow<GlobalSchema...>;
+
+    static constexpr std::size_t MIN_CAPACITY = 16;
+    // slots migrated per claim while growing
+    static constexpr std::size_t MIGRATION_CHUNK = 1024;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = row_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const row_type*;
+        using reference = const row_type&;
+
+        const_iterator(const std::atomic<row_type*>* slot_, const std::atomic<row_type*>* last_) : slot(slot_), last(last_) {
+            skip_empty();
+        }
+
+        const row_type& operator*() const {
+            return *slot->load(std::memory_order_acquire);
+        }
+
+        const row_type* operator->() const {
+            return slot->load(std::memory_order_acquire);
+        }
+
+        const_iterator& operator++() {
+            ++slot;
+            skip_empty();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return slot == other.slot;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return slot != other.slot;
+        }
+
+    private:
+        const std::atomic<row_type*>* slot;
+        const std::atomic<row_type*>* last;
+
+        void skip_empty() {
+            while (slot != last && !is_row(slot->load(std::memory_order_acquire))) {
+                ++slot;
+            }
+        }
+    };
+
+    explicit ConcurrentRowSet(std::size_t capacity = MIN_CAPACITY) {
+        first = new Slots(capacity_for(capacity));
+        current.store(first, std::memory_order_release);
+    }
+
+    ConcurrentRowSet(const ConcurrentRowSet&) = delete;
+    ConcurrentRowSet& operator=(const ConcurrentRowSet&) = delete;
+
+    // the moved-from set is left empty, with no array
+    ConcurrentRowSet(ConcurrentRowSet&& other) noexcept
+        : first(std::exchange(other.first, nullptr)),
+          current(other.current.exchange(nullptr, std::memory_order_acq_rel)),
+          row_count(other.row_count.exchange(0)) {}
+
+    ConcurrentRowSet& operator=(ConcurrentRowSet&& other) noexcept {
+        if (this != &other) {
+            std::swap(first, other.first);
+            Slots* slots = current.load(std::memory_order_acquire);
+            current.store(other.current.load(std::memory_order_acquire), std::memory_order_release);
+            other.current.store(slots, std::memory_order_release);
+            std::size_t count = row_count.load();
+            row_count.store(other.row_count.load());
+            other.row_count.store(count);
+        }
+        return *this;
+    }
+
+    ~ConcurrentRowSet() {
+        // every row is in the last array, the earlier ones were fully migrated into it
+        Slots* slots = first;
+        while (slots) {
+            Slots* next = slots->next.load(std::memory_order_acquire);
+            if (!next) {
+                for (std::size_t i = 0; i < slots->capacity; i++) {
+                    row_type* row = slots->slots[i].load(std::memory_order_acquire);
+                    if (is_row(row)) {
+                        delete row;
+                    }
+                }
+            }
+            delete slots;
+            slots = next;
+        }
+    }
+
+    // thread safe - false if an equal row is already in the set
+    bool insert(row_type row) {
+        std::unique_ptr<row_type> node;
+        while (true) {
+            Slots* slots = current_slots();
+            Probe result = insert_into(*slots, row, node);
+            if (result == Probe::INSERTED) {
+                row_count.fetch_add(1, std::memory_order_relaxed);
+                if (slots->filled.fetch_add(1, std::memory_order_acq_rel) + 1 > slots->capacity / 2) {
+                    migrate(slots);
+                }
+                return true;
+            }
+            if (result == Probe::FOUND) {
+                return false;
+            }
+            migrate(slots);
+        }
+    }
+
+    // thread safe - waits for a migration in progress rather than missing a row that is being copied
+    bool contains(const row_type& row) const {
+        const Slots* slots = current.load(std::memory_order_acquire);
+        while (slots) {
+            std::size_t mask = slots->capacity - 1;
+            bool frozen = false;
+            for (std::size_t i = 0; i < slots->capacity; i++) {
+                row_type* slot_row = slots->slots[(row.hash + i) & mask].load(std::memory_order_acquire);
+                if (slot_row == nullptr) {
+                    return false;
+                }
+                if (slot_row == frozen_marker()) {
+                    frozen = true;
+                    break;
+                }
+                if (slot_row->hash == row.hash && *slot_row == row) {
+                    return true;
+                }
+            }
+            if (!frozen) {
+                return false;
+            }
+            // the row may already have been copied to (or inserted into) the next array, but the next array only
+            // holds every row of this one once the migration is done
+            wait_migrated(*slots);
+            slots = slots->next.load(std::memory_order_acquire);
+        }
+        return false;
+    }
+
+    std::size_t count(const row_type& row) const {
+        return contains(row);
+    }
+
+    // hint that row is about to be inserted or probed
+    void prefetch(const row_type& row) const {
+        const Slots* slots = current.load(std::memory_order_acquire);
+        if (!slots) {
+            return;
+        }
+        __builtin_prefetch(&slots->slots[row.hash & (slots->capacity - 1)]);
+    }
+
+    // grows up front so row_count rows fit without migrating
+    void reserve(std::size_t row_count_) {
+        while (current_slots()->capacity / 2 < row_count_) {
+            migrate(current.load(std::memory_order_acquire));
+        }
+    }
+
+    std::size_t size() const {
+        return row_count.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t capacity() const {
+        const Slots* slots = current.load(std::memory_order_acquire);
+        return slots ? slots->capacity : 0;
+    }
+
+    const_iterator begin() const {
+        const Slots* slots = current.load(std::memory_order_acquire);
+        if (!slots) {
+            return const_iterator(nullptr, nullptr);
+        }
+        return const_iterator(slots->slots.get(), slots->slots.get() + slots->capacity);
+    }
+
+    const_iterator end() const {
+        const Slots* slots = current.load(std::memory_order_acquire);
+        if (!slots) {
+            return const_iterator(nullptr, nullptr);
+        }
+        return const_iterator(slots->slots.get() + slots->capacity, slots->slots.get() + slots->capacity);
+    }
+
+private:
+    struct Slots {
+        std::size_t capacity;
+        std::unique_ptr<std::atomic<row_type*>[]> slots;
+        // rows in this array (inserted or migrated in)
+        std::atomic<std::size_t> filled{0};
+        // the array this one is migrated into
+        std::atomic<Slots*> next{nullptr};
+        std::atomic<std::size_t> claimed{0};
+        std::atomic<std::size_t> migrated{0};
+
+        explicit Slots(std::size_t capacity_) : capacity(capacity_), slots(new std::atomic<row_type*>[capacity_]) {
+            for (std::size_t i = 0; i < capacity; i++) {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    enum class Probe {
+        INSERTED,
+        FOUND,
+        // the probe ran into a frozen slot (or a full array) - retry once the array is migrated
+        FROZEN,
+    };
+
+    Slots* first;
+    std::atomic<Slots*> current;
+    std::atomic<std::size_t> row_count{0};
+
+    // installs the first array of a moved-from set - racing inserts agree on one array
+    Slots* current_slots() {
+        Slots* slots = current.load(std::memory_order_acquire);
+        if (slots) {
+            return slots;
+        }
+        Slots* fresh = new Slots(MIN_CAPACITY);
+        if (current.compare_exchange_strong(slots, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            first = fresh;
+            return fresh;
+        }
+        delete fresh;
+        return slots;
+    }
+
+    static row_type* frozen_marker() {
+        return reinterpret_cast<row_type*>(std::uintptr_t(1));
+    }
+
+    static bool is_row(const row_type* row) {
+        return row != nullptr && row != frozen_marker();
+    }
+
+    static std::size_t capacity_for(std::size_t capacity) {
+        std::size_t power = MIN_CAPACITY;
+        while (power < capacity) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    // the row is moved into node the first time an empty slot is found, and node is released once it is
+    // published (node carries over to the retry on the next array otherwise)
+    static Probe insert_into(Slots& slots, row_type& row, std::unique_ptr<row_type>& node) {
+        std::size_t mask = slots.capacity - 1;
+        std::size_t hash = node ? node->hash : row.hash;
+        for (std::size_t i = 0; i < slots.capacity; i++) {
+            std::atomic<row_type*>& slot = slots.slots[(hash + i) & mask];
+            row_type* slot_row = slot.load(std::memory_order_acquire);
+            while (true) {
+                if (slot_row == frozen_marker()) {
+                    return Probe::FROZEN;
+                }
+                if (slot_row != nullptr) {
+                    const row_type& probe_row = node ? *node : row;
+                    if (slot_row->hash == hash && *slot_row == probe_row) {
+                        return Probe::FOUND;
+                    }
+                    break;
+                }
+                if (!node) {
+                    node = std::make_unique<row_type>(std::move(row));
+                }
+                // on failure slot_row is reloaded and the slot re-examined
+                if (slot.compare_exchange_weak(slot_row, node.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    node.release();
+                    return Probe::INSERTED;
+                }
+            }
+        }
+        return Probe::FROZEN;
+    }
+
+    // rows being migrated are distinct, so they only need an empty slot
+    static void place(Slots& slots, row_type* row) {
+        std::size_t mask = slots.capacity - 1;
+        for (std::size_t i = 0;; i++) {
+            std::atomic<row_type*>& slot = slots.slots[(row->hash + i) & mask];
+            row_type* empty = nullptr;
+            if (slot.compare_exchange_strong(empty, row, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                slots.filled.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    static void wait_migrated(const Slots& slots) {
+        while (slots.migrated.load(std::memory_order_acquire) < slots.capacity) {
+            std::this_thread::yield();
+        }
+    }
+
+    // freezes slots into their next array (allocating it if needed), helping with the slot chunks no one has
+    // claimed yet, and installs the next array once every slot is migrated
+    void migrate(Slots* slots) {
+        Slots* next = slots->next.load(std::memory_order_acquire);
+        if (!next) {
+            Slots* fresh = new Slots(slots->capacity * 2);
+            if (slots->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                next = fresh;
+            } else {
+                delete fresh;
+            }
+        }
+        while (true) {
+            std::size_t begin = slots->claimed.fetch_add(MIGRATION_CHUNK, std::memory_order_acq_rel);
+            if (begin >= slots->capacity) {
+                break;
+            }
+            std::size_t end = std::min(begin + MIGRATION_CHUNK, slots->capacity);
+            for (std::size_t i = begin; i < end; i++) {
+                row_type* row = nullptr;
+                // an empty slot is frozen, a slot holding a row keeps it forever and is copied
+                if (!slots->slots[i].compare_exchange_strong(row, frozen_marker(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    place(*next, row);
+                }
+            }
+            slots->migrated.fetch_add(end - begin, std::memory_order_acq_rel);
+        }
+        wait_migrated(*slots);
+        current.compare_exchange_strong(slots, next, std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+};
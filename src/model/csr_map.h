@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+
+#include "src/model/packed_key.h"
+#include "src/model/row.h"
+
+// compressed sparse row dictionary storage - the Y rows of every key are stored back to back in one payload
+// array and a hash index maps each key to its [offset, offset + size) range of the payload
+// - the maximum number of rows of a key (the dictionary degree) is tracked as the map is built
+// - built group by group (open_group, push_row..., close_group) or converted from any map of row sets
+// - the storage is immutable once built - storage allocated from the heap lives as long as its handles, so
+//   copies of it (e.g. to extend a dictionary) share it in O(1), while storage allocated from any other
+//   resource (e.g. a subproblem arena, which may be released before the copy) is deep copied
+// - an empty or moved-from map has no storage, so moves never allocate - it is created by the first build call
+template<typename... GlobalSchema>
+class CsrMap {
+public:
+    using row_type = HashableRow<GlobalSchema...>;
+    using key = key_type<GlobalSchema...>;
+
+    // keys with at most this many rows are compared by scanning
+    static constexpr std::size_t SCAN_COMPARE_DEGREE = 16;
+
+    // the rows of one key - contiguous, distinct, in insertion order
+    class Rows {
+    public:
+        Rows() : first(nullptr), last(nullptr) {}
+        Rows(const row_type* first_, const row_type* last_) : first(first_), last(last_) {}
+
+        const row_type* begin() const {
+            return first;
+        }
+
+        const row_type* end() const {
+            return last;
+        }
+
+        std::size_t size() const {
+            return last - first;
+        }
+
+        bool empty() const {
+            return first == last;
+        }
+
+        // linear scan - for membership tests over a whole group, hash the group instead
+        std::size_t count(const row_type& row) const {
+            return std::find(first, last, row) != last;
+        }
+
+    private:
+        const row_type* first;
+        const row_type* last;
+    };
+
+    using index_type = absl::flat_hash_map<
+        key,
+        std::pair<std::size_t, std::size_t>,
+        std::hash<key>,
+        std::equal_to<key>,
+        std::pmr::polymorphic_allocator<std::pair<const key, std::pair<std::size_t, std::size_t>>>>;
+
+    class const_iterator {
+    public:
+        const_iterator(typename index_type::const_iterator it_, const row_type* payload_) : it(it_), payload(payload_) {}
+
+        std::pair<const key&, Rows> operator*() const {
+            return {it->first, Rows(payload + it->second.first, payload + it->second.first + it->second.second)};
+        }
+
+        const_iterator& operator++() {
+            ++it;
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return it == other.it;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return it != other.it;
+        }
+
+    private:
+        typename index_type::const_iterator it;
+        const row_type* payload;
+    };
+
+    CsrMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : memory(resource) {}
+
+    // deep copy into resource
+    CsrMap(const CsrMap& other, std::pmr::memory_resource* resource)
+        : memory(resource), storage(other.storage ? std::make_shared<Storage>(*other.storage, resource) : nullptr) {}
+
+    // copies are made on the default resource unless the storage can be shared
+    CsrMap(const CsrMap& other)
+        : memory(std::pmr::get_default_resource()), storage(other.share_or_copy(std::pmr::get_default_resource())) {}
+
+    // the moved-from map is left empty (on the same resource)
+    CsrMap(CsrMap&& other) noexcept : memory(other.memory), storage(std::move(other.storage)) {}
+
+    CsrMap& operator=(const CsrMap& other) {
+        if (this != &other) {
+            storage = other.share_or_copy(std::pmr::get_default_resource());
+            memory = std::pmr::get_default_resource();
+        }
+        return *this;
+    }
+
+    CsrMap& operator=(CsrMap&& other) noexcept {
+        if (this != &other) {
+            memory = other.memory;
+            storage = std::move(other.storage);
+        }
+        return *this;
+    }
+
+    // a map with the same contents for use from resource - the storage is shared when it is heap allocated or
+    // already allocated from resource, and deep copied into resource otherwise
+    CsrMap copy_to(std::pmr::memory_resource* resource) const {
+        return CsrMap(resource, share_or_copy(resource));
+    }
+
+    // from any map of key -> row set (e.g. a RowMap)
+    template<typename Map, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Map>, CsrMap>
+        && !std::is_convertible_v<const Map&, std::pmr::memory_resource*>>>
+    CsrMap(const Map& map, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : CsrMap(resource) {
+        std::size_t row_count = 0;
+        for (const auto& [map_key, rows] : map) {
+            row_count += rows.size();
+        }
+        reserve(map.size(), row_count);
+        for (const auto& [map_key, rows] : map) {
+            open_group();
+            for (const auto& row : rows) {
+                push_row(row);
+            }
+            close_group(map_key);
+        }
+    }
+
+    // building a map whose storage is shared first gives it a private copy
+    void reserve(std::size_t key_count, std::size_t row_count) {
+        Storage& building = mutable_storage();
+        building.index.reserve(key_count);
+        building.payload.reserve(row_count);
+    }
+
+    void open_group() {
+        Storage& building = mutable_storage();
+        building.group_offset = building.payload.size();
+    }
+
+    // rows of a group must be distinct
+    void push_row(row_type row) {
+        mutable_storage().payload.push_back(std::move(row));
+    }
+
+    void close_group(const key& group_key) {
+        Storage& building = mutable_storage();
+        std::size_t group_size = building.payload.size() - building.group_offset;
+        if (!building.index.try_emplace(group_key, building.group_offset, group_size).second) {
+            throw std::logic_error("Duplicate key in CSR map");
+        }
+        building.max_degree = std::max(building.max_degree, group_size);
+    }
+
+    std::size_t size() const {
+        return index().size();
+    }
+
+    bool empty() const {
+        return index().empty();
+    }
+
+    std::size_t count(const key& lookup_key) const {
+        return index().count(lookup_key);
+    }
+
+    // hint that lookup_key is about to be probed
+    void prefetch(const key& lookup_key) const {
+        index().prefetch(lookup_key);
+    }
+
+    // empty rows if the key is absent
+    Rows find(const key& lookup_key) const {
+        auto it = index().find(lookup_key);
+        if (it == index().end()) {
+            return Rows();
+        }
+        return range(it->second);
+    }
+
+    Rows at(const key& lookup_key) const {
+        auto it = index().find(lookup_key);
+        if (it == index().end()) {
+            throw std::out_of_range("Key not found in CSR map");
+        }
+        return range(it->second);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(index().begin(), storage ? storage->payload.data() : nullptr);
+    }
+
+    const_iterator end() const {
+        return const_iterator(index().end(), storage ? storage->payload.data() : nullptr);
+    }
+
+    std::size_t degree() const {
+        return storage ? storage->max_degree : 0;
+    }
+
+    // total number of rows over every key
+    std::size_t row_count() const {
+        return storage ? storage->payload.size() : 0;
+    }
+
+    // two empty maps share no storage either
+    bool shares_storage(const CsrMap& other) const {
+        return storage == other.storage;
+    }
+
+    // resource the map builds its storage from (storage shared with a heap allocated map stays on the heap)
+    std::pmr::memory_resource* resource() const {
+        return memory;
+    }
+
+    // same keys with the same row sets (row order within a key is ignored)
+    bool operator==(const CsrMap& other) const {
+        if (shares_storage(other)) {
+            return true;
+        }
+        if (size() != other.size() || row_count() != other.row_count()) {
+            return false;
+        }
+        // rows of a key are distinct, so equal sizes and containment mean equal sets - large keys are compared
+        // through a hash set of the other side's rows (linear scans would be quadratic in the degree)
+        auto row_hash = [](const row_type* row) { return row->hash; };
+        auto row_eq = [](const row_type* row_1, const row_type* row_2) { return *row_1 == *row_2; };
+        absl::flat_hash_set<const row_type*, decltype(row_hash), decltype(row_eq)> other_set(0, row_hash, row_eq);
+        for (const auto& [map_key, offsets] : index()) {
+            auto it = other.index().find(map_key);
+            if (it == other.index().end() || it->second.second != offsets.second) {
+                return false;
+            }
+            Rows rows = range(offsets);
+            Rows other_rows = other.range(it->second);
+            if (rows.size() <= SCAN_COMPARE_DEGREE) {
+                for (const auto& row : rows) {
+                    if (!other_rows.count(row)) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            other_set.clear();
+            for (const auto& row : other_rows) {
+                other_set.insert(&row);
+            }
+            for (const auto& row : rows) {
+                if (!other_set.contains(&row)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Storage {
+        std::pmr::vector<row_type> payload;
+        index_type index;
+        std::size_t max_degree = 0;
+        std::size_t group_offset = 0;
+
+        explicit Storage(std::pmr::memory_resource* resource) : payload(resource), index(resource) {}
+
+        Storage(const Storage& other, std::pmr::memory_resource* resource)
+            : payload(other.payload, resource), index(other.index, resource),
+              max_degree(other.max_degree), group_offset(other.group_offset) {}
+    };
+
+    std::pmr::memory_resource* memory;
+    // null while empty
+    std::shared_ptr<Storage> storage;
+
+    CsrMap(std::pmr::memory_resource* resource, std::shared_ptr<Storage> storage_)
+        : memory(resource), storage(std::move(storage_)) {}
+
+    static const index_type& empty_index() {
+        static const index_type index;
+        return index;
+    }
+
+    const index_type& index() const {
+        return storage ? storage->index : empty_index();
+    }
+
+    Storage& mutable_storage() {
+        if (!storage) {
+            storage = std::make_shared<Storage>(memory);
+        } else if (storage.use_count() > 1) {
+            storage = std::make_shared<Storage>(*storage, memory);
+        }
+        return *storage;
+    }
+
+    std::shared_ptr<Storage> share_or_copy(std::pmr::memory_resource* target) const {
+        if (!storage) {
+            return nullptr;
+        }
+        std::pmr::memory_resource* source = storage->payload.get_allocator().resource();
+        if (source->is_equal(*std::pmr::new_delete_resource()) || source->is_equal(*target)) {
+            return storage;
+        }
+        return std::make_shared<Storage>(*storage, target);
+    }
+
+    Rows range(const std::pair<std::size_t, std::size_t>& offsets) const {
+        return Rows(storage->payload.data() + offsets.first, storage->payload.data() + offsets.first + offsets.second);
+    }
+};
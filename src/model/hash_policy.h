@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "src/model/interned_string.h"
+
+// row hash policies - a policy hashes individual column values and combines the column hashes of a row
+// - hash_column(value) -> column hash
+// - combine(seed, index, column_hash) -> seed (applied to each present column in order, starting from init(N))
+
+// boost-style combine over std::hash (std::hash<int> is the identity in libstdc++)
+struct StdHashPolicy {
+    template<typename T>
+    static std::size_t hash_column(const T& value) {
+        return std::hash<T>{}(value);
+    }
+
+    static std::size_t init(std::size_t column_count) {
+        return column_count;
+    }
+
+    static std::size_t combine(std::size_t seed, std::size_t index, std::size_t column_hash) {
+        return seed ^ (column_hash + 0x9e3779b9 + (index << 32) + (seed << 6) + (seed >> 2));
+    }
+};
+
+// wyhash-style multiply-fold mixing - fixed-width values are hashed from their bits in a single 128-bit
+// multiply, strings are hashed 8 bytes at a time
+struct WyHashPolicy {
+    static constexpr uint64_t P0 = 0xa0761d6478bd642fULL;
+    static constexpr uint64_t P1 = 0xe7037ed1a0b428dbULL;
+    static constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+
+    static uint64_t mum(uint64_t a, uint64_t b) {
+        __uint128_t r = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+    }
+
+    static uint64_t hash_bytes(const char* data, std::size_t size) {
+        uint64_t seed = P0 ^ size;
+        std::size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data + offset, sizeof(uint64_t));
+            seed = mum(word ^ P1, seed ^ P0);
+        }
+        if (offset < size) {
+            uint64_t word = 0;
+            std::memcpy(&word, data + offset, size - offset);
+            seed = mum(word ^ P1, seed ^ P2);
+        }
+        return mum(seed ^ P2, size ^ P1);
+    }
+
+    template<typename T>
+    static std::size_t hash_column(const T& value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            // -0.0 == 0.0 so both must hash to the same value
+            T normalized = (value == 0) ? T(0) : value;
+            uint64_t bits = 0;
+            std::memcpy(&bits, &normalized, sizeof(T));
+            return mum(bits ^ P0, P1);
+        } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            return mum(static_cast<uint64_t>(value) ^ P0, P1);
+        } else if constexpr (std::is_same_v<T, InternedString>) {
+            return mum(static_cast<uint64_t>(value.id) ^ P0, P1);
+        } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+            return hash_bytes(value.data(), value.size());
+        } else {
+            return mum(static_cast<uint64_t>(std::hash<T>{}(value)) ^ P0, P1);
+        }
+    }
+
+    static std::size_t init(std::size_t column_count) {
+        return P2 ^ column_count;
+    }
+
+    static std::size_t combine(std::size_t seed, std::size_t index, std::size_t column_hash) {
+        return mum(seed ^ column_hash, P1 ^ index);
+    }
+};
+
+// customization point - specialize for a schema to select its row hash policy
+template<typename... GlobalSchema>
+struct row_hash_policy {
+    using type = WyHashPolicy;
+};
+
+template<typename... GlobalSchema>
+using row_hash_policy_t = typename row_hash_policy<GlobalSchema...>::type;
+
+// combines the column hashes of the present columns into a row hash
+template<typename Policy, std::size_t N>
+std::size_t combine_hashes(const std::array<std::size_t, N>& column_hashes, const std::bitset<N>& attributes) {
+    std::size_t seed = Policy::init(N);
+    for (std::size_t i = 0; i < N; i++) {
+        if (attributes[i]) {
+            seed = Policy::combine(seed, i, column_hashes[i]);
+        }
+    }
+    return seed;
+}
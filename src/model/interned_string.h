@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// global dictionary encoding for string columns - each distinct string is assigned a dense 32-bit id
+class StringDictionary {
+public:
+    static StringDictionary& instance() {
+        static StringDictionary dictionary;
+        return dictionary;
+    }
+
+    uint32_t intern(const std::string& value) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = ids.find(value);
+            if (it != ids.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(value);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = strings.size();
+        strings.push_back(value);
+        ids[strings.back()] = id;
+        return id;
+    }
+
+    // deque elements are never moved so the returned reference stays valid
+    const std::string& lookup(uint32_t id) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return strings.at(id);
+    }
+
+    std::size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return strings.size();
+    }
+
+private:
+    StringDictionary() {
+        // id 0 is reserved for the empty string (the value of a default-constructed InternedString)
+        strings.push_back(std::string());
+        ids[strings.back()] = 0;
+    }
+
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// string column type carrying only its dictionary id - compared and hashed as an integer
+struct InternedString {
+    uint32_t id = 0;
+
+    InternedString() = default;
+
+    explicit InternedString(const std::string& value) : id(StringDictionary::instance().intern(value)) {}
+
+    const std::string& str() const {
+        return StringDictionary::instance().lookup(id);
+    }
+
+    bool operator==(const InternedString& other) const {
+        return id == other.id;
+    }
+
+    bool operator!=(const InternedString& other) const {
+        return id != other.id;
+    }
+};
+
+template<>
+struct std::hash<InternedString> {
+    std::size_t operator()(const InternedString& value) const {
+        return std::hash<uint32_t>{}(value.id);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const InternedString& value) {
+    return os << value.str();
+}
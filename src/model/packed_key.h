@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "src/model/row.h"
+
+// packed lookup key - the masked columns of a row serialized back to back into a byte buffer (inline for
+// narrow keys, see PackedKey)
+// (only available when every column type is trivially copyable, e.g. numeric or InternedString columns)
+template<typename... GlobalSchema>
+constexpr bool is_packable_v = (std::is_trivially_copyable_v<GlobalSchema> && ...);
+
+// bytes of the count widest columns of the schema
+template<typename... GlobalSchema>
+constexpr std::size_t widest_columns_size(std::size_t count) {
+    std::array<std::size_t, sizeof...(GlobalSchema)> sizes = {sizeof(GlobalSchema)...};
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < count && i < sizes.size(); i++) {
+        std::size_t widest = i;
+        for (std::size_t j = i + 1; j < sizes.size(); j++) {
+            if (sizes[j] > sizes[widest]) {
+                widest = j;
+            }
+        }
+        total += sizes[widest];
+        sizes[widest] = sizes[i];
+    }
+    return total;
+}
+
+template<typename... GlobalSchema>
+struct PackedKey {
+    // bytes of every column of the schema
+    static constexpr std::size_t CAPACITY = (sizeof(GlobalSchema) + ...);
+    // keys of up to INLINE_COLUMNS columns (the bytes of the widest ones) are stored inline, so a narrow key over
+    // a wide schema stays small - only wider keys spill to one heap allocation
+    static constexpr std::size_t INLINE_COLUMNS = 4;
+    static constexpr std::size_t INLINE_CAPACITY = widest_columns_size<GlobalSchema...>(INLINE_COLUMNS);
+
+    uint32_t size;
+    attr_type<GlobalSchema...> attributes;
+    std::size_t hash;
+
+    PackedKey(const attr_type<GlobalSchema...>& attributes_, const HashableRow<GlobalSchema...>& row)
+        : size(packed_size(attributes_ & row.attributes)), attributes(attributes_ & row.attributes) {
+        if (spilled()) {
+            storage.heap_bytes = new unsigned char[size];
+        }
+        std::size_t offset = 0;
+        pack(row, offset, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+        hash = cache_hash();
+    }
+
+    // keys of full rows - allows rows to be used directly for dictionary lookups
+    PackedKey(const HashableRow<GlobalSchema...>& row) : PackedKey(row.attributes, row) {}
+
+    PackedKey(const PackedKey& other) : size(other.size), attributes(other.attributes), hash(other.hash) {
+        if (spilled()) {
+            storage.heap_bytes = new unsigned char[size];
+        }
+        std::memcpy(data(), other.data(), size);
+    }
+
+    PackedKey(PackedKey&& other) noexcept : size(other.size), attributes(other.attributes), hash(other.hash), storage(other.storage) {
+        // the moved-from key keeps its size, so it must not free the bytes it handed over
+        other.size = 0;
+    }
+
+    PackedKey& operator=(PackedKey other) noexcept {
+        std::swap(size, other.size);
+        std::swap(attributes, other.attributes);
+        std::swap(hash, other.hash);
+        std::swap(storage, other.storage);
+        return *this;
+    }
+
+    ~PackedKey() {
+        if (spilled()) {
+            delete[] storage.heap_bytes;
+        }
+    }
+
+    const unsigned char* data() const {
+        return spilled() ? storage.heap_bytes : storage.inline_bytes;
+    }
+
+    unsigned char* data() {
+        return spilled() ? storage.heap_bytes : storage.inline_bytes;
+    }
+
+    bool operator==(const PackedKey& other) const {
+        return hash == other.hash
+            && size == other.size
+            && attributes == other.attributes
+            && std::memcmp(data(), other.data(), size) == 0;
+    }
+
+    template<std::size_t index>
+    void pack_idx(const HashableRow<GlobalSchema...>& row, std::size_t& offset) {
+        using col_type = elem_type<index, GlobalSchema...>;
+        if (attributes[index]) {
+            col_type value = row.template get<index>();
+            if constexpr (std::is_floating_point_v<col_type>) {
+                // -0.0 == 0.0 so both must serialize to the same bytes
+                if (value == 0) {
+                    value = 0;
+                }
+            }
+            std::memcpy(data() + offset, &value, sizeof(col_type));
+            offset += sizeof(col_type);
+        }
+    }
+
+    template<std::size_t... Indices>
+    void pack(const HashableRow<GlobalSchema...>& row, std::size_t& offset, std::index_sequence<Indices...>) {
+        (pack_idx<Indices>(row, offset), ...);
+    }
+
+    template<std::size_t... Indices>
+    static uint32_t packed_size_pack(const attr_type<GlobalSchema...>& attributes_, std::index_sequence<Indices...>) {
+        return ((attributes_[Indices] ? sizeof(elem_type<Indices, GlobalSchema...>) : 0) + ...);
+    }
+
+    static uint32_t packed_size(const attr_type<GlobalSchema...>& attributes_) {
+        return packed_size_pack(attributes_, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+    }
+
+    // single pass over the packed bytes, 8 bytes at a time
+    std::size_t cache_hash() const {
+        uint64_t seed = std::hash<attr_type<GlobalSchema...>>{}(attributes) ^ 0x9e3779b97f4a7c15ULL;
+        std::size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data() + offset, sizeof(uint64_t));
+            seed = (seed ^ word) * 0xbf58476d1ce4e5b9ULL;
+            seed ^= seed >> 31;
+        }
+        if (offset < size) {
+            uint64_t word = 0;
+            std::memcpy(&word, data() + offset, size - offset);
+            seed = (seed ^ word) * 0xbf58476d1ce4e5b9ULL;
+            seed ^= seed >> 31;
+        }
+        seed = (seed ^ size) * 0x94d049bb133111ebULL;
+        return seed ^ (seed >> 29);
+    }
+
+private:
+    union Storage {
+        unsigned char inline_bytes[INLINE_CAPACITY];
+        unsigned char* heap_bytes;
+    } storage;
+
+    bool spilled() const {
+        return size > INLINE_CAPACITY;
+    }
+};
+
+template<typename... GlobalSchema>
+struct std::hash<PackedKey<GlobalSchema...>> {
+    std::size_t operator()(const PackedKey<GlobalSchema...>& key) const {
+        return key.hash;
+    }
+};
+
+// dictionary key type - packed keys when the schema allows it, masked rows otherwise
+template<typename... GlobalSchema>
+using key_type = std::conditional_t<is_packable_v<GlobalSchema...>, PackedKey<GlobalSchema...>, HashableRow<GlobalSchema...>>;
+
+template<typename... GlobalSchema>
+key_type<GlobalSchema...> mask_key(
+        const attr_type<GlobalSchema...>& attributes,
+        const HashableRow<GlobalSchema...>& row) {
+    if constexpr (is_packable_v<GlobalSchema...>) {
+        return PackedKey<GlobalSchema...>(attributes, row);
+    } else {
+        return mask_row<GlobalSchema...>(attributes, row);
+    }
+}
+
+// unpack
+template<std::size_t index, typename... GlobalSchema>
+elem_type<index, GlobalSchema...> unpack_idx(const PackedKey<GlobalSchema...>& key, std::size_t& offset) {
+    using col_type = elem_type<index, GlobalSchema...>;
+    col_type value = col_type();
+    if (key.attributes[index]) {
+        std::memcpy(&value, key.data() + offset, sizeof(col_type));
+        offset += sizeof(col_type);
+    }
+    return value;
+}
+
+template<typename... GlobalSchema, std::size_t... Indices>
+HashableRow<GlobalSchema...> unpack_pack(const PackedKey<GlobalSchema...>& key, std::index_sequence<Indices...>) {
+    std::size_t offset = 0;
+    // braced initialization evaluates left to right so offsets advance in column order
+    row_data_type<GlobalSchema...> data{unpack_idx<Indices, GlobalSchema...>(key, offset)...};
+    return HashableRow<GlobalSchema...>(std::move(data), key.attributes);
+}
+
+template<typename... GlobalSchema>
+HashableRow<GlobalSchema...> unpack(const PackedKey<GlobalSchema...>& key) {
+    return unpack_pack(key, std::make_index_sequence<sizeof...(GlobalSchema)>{});
+}
+
+template<typename... GlobalSchema>
+const HashableRow<GlobalSchema...>& unpack(const HashableRow<GlobalSchema...>& key) {
+    return key;
+}
+
+// print
+template<typename... GlobalSchema>
+void print(const PackedKey<GlobalSchema...>& key) {
+    print(unpack(key));
+}
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <fmt/core.h>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 
 #include "src/utils.h"
 #include "src/model/table.h"
+#include "src/model/witness_map.h"
 #include "src/model/row.h"
 
 using Constraint = long double;
@@ -40,27 +45,125 @@ struct Submodularity {
     }
 };
 
+// symbolic part of a subproblem - which case applies (and how the terms change) depends only on this state,
+// the tables and dictionaries only decide the bound checks and partition fan-out
+template<typename... GlobalSchema>
+struct SymbolicState {
+    std::unordered_map<OutputAttributes<GlobalSchema...>, unsigned> Z;
+    WitnessMap<Monotonicity<GlobalSchema...>> D;
+    WitnessMap<Monotonicity<GlobalSchema...>> M;
+    WitnessMap<Submodularity<GlobalSchema...>> S;
+
+    bool operator==(const SymbolicState& other) const {
+        return Z == other.Z && D == other.D && M == other.M && S == other.S;
+    }
+};
+
+// memory region for the tables and dictionaries created for one subproblem - released in bulk once the
+// last subproblem or handle referencing it is destroyed
+struct SubproblemArena {
+    std::pmr::monotonic_buffer_resource resource;
+};
+
+// immutable shared handle - subproblems copy handles to the tables and dictionaries they inherit, so
+// creating a child only allocates the tables and dictionaries it adds
+template<typename T>
+class Shared {
+public:
+    Shared(T value) : ptr(std::make_shared<Entry>(std::move(value))) {}
+
+    // owner (e.g. the arena the value was allocated from) is kept alive as long as the value is referenced
+    Shared(T value, std::shared_ptr<void> owner)
+        : ptr(new Entry(std::move(value), true), [owner = std::move(owner)](Entry* p) { delete p; }) {}
+
+    const T& operator*() const {
+        return ptr->value;
+    }
+
+    const T* operator->() const {
+        return &ptr->value;
+    }
+
+    long use_count() const {
+        return ptr.use_count();
+    }
+
+    bool same_object(const Shared& other) const {
+        return ptr == other.ptr;
+    }
+
+    // moves the value out when this is the last handle and the value does not live in an owner's memory (e.g.
+    // an arena released with the handle) - the handle is left empty then, and untouched otherwise
+    std::optional<T> release() {
+        if (!ptr || ptr.use_count() != 1 || ptr->owned) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(ptr->value));
+        ptr.reset();
+        return value;
+    }
+
+    // content_hash of the value - computed once and shared by every copy of the handle
+    std::size_t hash_content() const {
+        std::call_once(ptr->hashed, [this]() { ptr->hash = content_hash(ptr->value); });
+        return ptr->hash;
+    }
+
+private:
+    struct Entry {
+        explicit Entry(T value_, bool owned_ = false) : value(std::move(value_)), owned(owned_) {}
+
+        T value;
+        bool owned;
+        std::once_flag hashed;
+        std::size_t hash = 0;
+    };
+
+    std::shared_ptr<Entry> ptr;
+};
+
 template<typename... GlobalSchema>
 struct Subproblem {
     Subproblem(
         std::unordered_map<OutputAttributes<GlobalSchema...>, unsigned> Z_,
-        std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D_,
-        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> Tn_tables_,
-        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Dictionary<GlobalSchema...>, Constraint>>> Tn_dicts_,
-        std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> M_,
-        std::unordered_map<Submodularity<GlobalSchema...>, unsigned> S_,
-        long double global_bound_
-    ) : Z(Z_), D(D_), Tn_tables(Tn_tables_), Tn_dicts(Tn_dicts_), M(M_), S(S_), global_bound(global_bound_) {
+        WitnessMap<Monotonicity<GlobalSchema...>> D_,
+        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_,
+        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts_,
+        WitnessMap<Monotonicity<GlobalSchema...>> M_,
+        WitnessMap<Submodularity<GlobalSchema...>> S_,
+        long double global_bound_,
+        std::shared_ptr<SubproblemArena> arena_ = nullptr
+    ) : arena(std::move(arena_)), Z(std::move(Z_)), D(std::move(D_)), Tn_tables(std::move(Tn_tables_)), Tn_dicts(std::move(Tn_dicts_)),
+        M(std::move(M_)), S(std::move(S_)), global_bound(global_bound_) {
         verify_state();
     }
 
+    Subproblem(
+        SymbolicState<GlobalSchema...> state,
+        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_,
+        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts_,
+        long double global_bound_,
+        std::shared_ptr<SubproblemArena> arena_ = nullptr
+    ) : Subproblem(std::move(state.Z), std::move(state.D), std::move(Tn_tables_), std::move(Tn_dicts_),
+        std::move(state.M), std::move(state.S), global_bound_, std::move(arena_)) {}
+
+    // arena for the tables and dictionaries this subproblem added (their handles also keep it alive)
+    std::shared_ptr<SubproblemArena> arena;
     std::unordered_map<OutputAttributes<GlobalSchema...>, unsigned> Z;
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D;
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> Tn_tables;
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Dictionary<GlobalSchema...>, Constraint>>> Tn_dicts;
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> M;
-    std::unordered_map<Submodularity<GlobalSchema...>, unsigned> S;
+    WitnessMap<Monotonicity<GlobalSchema...>> D;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts;
+    WitnessMap<Monotonicity<GlobalSchema...>> M;
+    WitnessMap<Submodularity<GlobalSchema...>> S;
     long double global_bound;
+
+    SymbolicState<GlobalSchema...> symbolic_state() const {
+        return SymbolicState<GlobalSchema...>{Z, D, M, S};
+    }
+
+    std::pmr::memory_resource* resource() const {
+        return arena ? &arena->resource : std::pmr::get_default_resource();
+    }
     
     void verify_state() const {
         // TODO:
@@ -93,6 +196,30 @@ struct std::hash<Submodularity<GlobalSchema...>> {
     }
 };
 
+// order independent - sums the hashes of the (term, count) entries of each map
+template<typename... GlobalSchema>
+struct std::hash<SymbolicState<GlobalSchema...>> {
+    template<typename Terms>
+    static std::size_t hash_terms(const Terms& terms) {
+        std::size_t sum = 0;
+        for (const auto& [term, count] : terms) {
+            std::size_t seed = std::hash<std::decay_t<decltype(term)>>{}(term);
+            seed ^= count + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            sum += seed;
+        }
+        return sum;
+    }
+
+    std::size_t operator()(const SymbolicState<GlobalSchema...>& state) const {
+        std::size_t seed = 0;
+        seed ^= hash_terms(state.Z) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= hash_terms(state.D) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= hash_terms(state.M) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= hash_terms(state.S) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
 template<typename... GlobalSchema>
 void print(const Subproblem<GlobalSchema...> subproblem) {
     std::cout << "Subproblem: -----" << std::endl;
@@ -0,0 +1,507 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+
+#include "src/thread_pool.h"
+#include "src/model/sharded_row_set.h"
+#include "src/model/table.h"
+#include "src/model/row.h"
+
+// morsel-driven parallel table operators - the input rows are split into morsels of MORSEL_SIZE rows that run
+// as tasks on a shared pool, each task writes its output into per-shard buffers (sharded by the cached row or
+// key hash), and each shard is then merged by its own task, so no output structure is shared between threads
+// - row outputs are ShardedTables whose shards are the merged shards, so no pass over the rows is serial
+// - inputs below PARALLEL_MIN_ROWS (or a single-thread pool) run the sequential operator (its output moved
+//   into a single shard)
+// - must be called from outside the pool's tasks (they wait on the pool)
+constexpr std::size_t MORSEL_SIZE = 1 << 14;
+constexpr std::size_t PARALLEL_MIN_ROWS = 1 << 16;
+
+inline bool run_parallel(const WorkStealingPool& pool, std::size_t row_count) {
+    return pool.size() > 1 && row_count >= PARALLEL_MIN_ROWS;
+}
+
+// a few shards per worker so the merge tasks balance
+inline unsigned shard_bits(const WorkStealingPool& pool) {
+    return std::ceil(std::log2(pool.size() * 4));
+}
+
+template<typename TableRows, typename... GlobalSchema>
+std::vector<const HashableRow<GlobalSchema...>*> row_pointers(const BasicTable<TableRows, GlobalSchema...>& table) {
+    std::vector<const HashableRow<GlobalSchema...>*> pointers;
+    pointers.reserve(table.data.size());
+    for (const auto& row : table.data) {
+        pointers.push_back(&row);
+    }
+    return pointers;
+}
+
+// fn(morsel, begin, end) for each morsel of [0, count)
+template<typename Fn>
+std::size_t for_each_morsel(WorkStealingPool& pool, std::size_t count, Fn&& fn) {
+    std::size_t morsel_count = (count + MORSEL_SIZE - 1) / MORSEL_SIZE;
+    for (std::size_t morsel = 0; morsel < morsel_count; morsel++) {
+        std::size_t begin = morsel * MORSEL_SIZE;
+        std::size_t end = std::min(begin + MORSEL_SIZE, count);
+        pool.submit([&fn, morsel, begin, end](std::size_t) { fn(morsel, begin, end); });
+    }
+    pool.wait();
+    return morsel_count;
+}
+
+// fn(shard) for each shard
+template<typename Fn>
+void for_each_shard(WorkStealingPool& pool, std::size_t shard_count, Fn&& fn) {
+    for (std::size_t shard = 0; shard < shard_count; shard++) {
+        pool.submit([&fn, shard](std::size_t) { fn(shard); });
+    }
+    pool.wait();
+}
+
+// output buffers of every (morsel, shard) pair - morsel tasks only write their own buffers
+// - shards are assigned like the shards of a ShardedRowSet with the same bits
+template<typename T>
+class ShardedBuffers {
+public:
+    ShardedBuffers(std::size_t morsel_count, unsigned bits_)
+        : bits(bits_), buffers(morsel_count, std::vector<std::vector<T>>(std::size_t(1) << bits_)) {}
+
+    std::size_t shard_count() const {
+        return std::size_t(1) << bits;
+    }
+
+    void push(std::size_t morsel, std::size_t hash, T value) {
+        buffers[morsel][bits == 0 ? 0 : radix_partition(hash, bits)].push_back(std::move(value));
+    }
+
+    // values buffered for a shard
+    std::size_t shard_size(std::size_t shard) const {
+        std::size_t count = 0;
+        for (const auto& morsel_buffers : buffers) {
+            count += morsel_buffers[shard].size();
+        }
+        return count;
+    }
+
+    // fn(value) for every value of a shard, morsel by morsel
+    template<typename Fn>
+    void drain(std::size_t shard, Fn&& fn) {
+        for (auto& morsel_buffers : buffers) {
+            for (T& value : morsel_buffers[shard]) {
+                fn(value);
+            }
+            std::vector<T>().swap(morsel_buffers[shard]);
+        }
+    }
+
+private:
+    unsigned bits;
+    std::vector<std::vector<std::vector<T>>> buffers;
+};
+
+// each shard's task inserts the rows buffered for it into the same shard of rows (rows has as many shards as
+// sharded) - the rows are hashed into one set, once
+template<typename... GlobalSchema>
+void merge_sharded_rows(WorkStealingPool& pool, ShardedBuffers<HashableRow<GlobalSchema...>>& sharded, ShardedRowSet<GlobalSchema...>& rows) {
+    for_each_shard(pool, sharded.shard_count(), [&](std::size_t shard) {
+        RowSet<GlobalSchema...>& shard_rows = rows.shard(shard);
+        shard_rows.reserve(shard_rows.size() + sharded.shard_size(shard));
+        sharded.drain(shard, [&](HashableRow<GlobalSchema...>& row) { shard_rows.insert(std::move(row)); });
+    });
+}
+
+// output of a sequential operator, as a single shard
+template<typename... GlobalSchema>
+ShardedTable<GlobalSchema...> single_shard(Table<GlobalSchema...> table) {
+    return ShardedTable<GlobalSchema...>{ShardedRowSet<GlobalSchema...>(std::move(table.data)), table.attributes};
+}
+
+// rows of a sharded table as one table allocated from resource - serial, for consumers that need a single
+// RowSet (a single shard already allocated from resource is moved)
+template<typename... GlobalSchema>
+Table<GlobalSchema...> merge_shards(ShardedTable<GlobalSchema...> table, std::pmr::memory_resource* resource) {
+    if (table.data.shard_count() == 1 && table.data.shard(0).get_allocator().resource() == resource) {
+        return Table<GlobalSchema...>{std::move(table.data.shard(0)), table.attributes};
+    }
+    Table<GlobalSchema...> merged{RowSet<GlobalSchema...>(resource), table.attributes};
+    merged.data.reserve(table.data.size());
+    for (const auto& row : table.data) {
+        merged.data.insert(row);
+    }
+    return merged;
+}
+
+// projection
+template<typename TableRows, typename... GlobalSchema>
+ShardedTable<GlobalSchema...> parallel_project(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& proj_attrs,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    if (!run_parallel(pool, table.data.size())) {
+        return single_shard(project(table, proj_attrs, resource));
+    }
+    std::vector<const HashableRow<GlobalSchema...>*> rows = row_pointers(table);
+    ShardedBuffers<HashableRow<GlobalSchema...>> sharded((rows.size() + MORSEL_SIZE - 1) / MORSEL_SIZE, shard_bits(pool));
+    for_each_morsel(pool, rows.size(), [&](std::size_t morsel, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            HashableRow<GlobalSchema...> proj_row = mask_row<GlobalSchema...>(proj_attrs, *rows[i]);
+            std::size_t hash = proj_row.hash;
+            sharded.push(morsel, hash, std::move(proj_row));
+        }
+    });
+    ShardedTable<GlobalSchema...> proj_table{ShardedRowSet<GlobalSchema...>(shard_bits(pool), resource), proj_attrs};
+    merge_sharded_rows(pool, sharded, proj_table.data);
+    return proj_table;
+}
+
+// join - emit(morsel, join_row) for every match of every row of table
+template<typename Emit, typename TableRows, typename... GlobalSchema>
+void parallel_probe_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const CsrMap<GlobalSchema...>& map,
+        const attr_type<GlobalSchema...>& key_attrs,
+        const attr_type<GlobalSchema...>& row_attrs,
+        const attr_type<GlobalSchema...>& attrs_Y,
+        Emit&& emit) {
+    using key = key_type<GlobalSchema...>;
+    using Probe = std::pair<key, const HashableRow<GlobalSchema...>*>;
+    std::vector<const HashableRow<GlobalSchema...>*> rows = row_pointers(table);
+    for_each_morsel(pool, rows.size(), [&](std::size_t morsel, std::size_t begin, std::size_t end) {
+        batched_probe(map, rows.begin() + begin, rows.begin() + end,
+            [&key_attrs](const HashableRow<GlobalSchema...>* row) { return Probe(mask_key<GlobalSchema...>(key_attrs, *row), row); },
+            [](const Probe& probe) -> const key& { return probe.first; },
+            [&](const Probe& probe) {
+                for (const HashableRow<GlobalSchema...>& row_Y : map.find(probe.first)) {
+                    emit(morsel, join_rows<GlobalSchema...>(*probe.second, row_Y, row_attrs, attrs_Y));
+                }
+            });
+    });
+}
+
+template<typename TableRows, typename... GlobalSchema>
+ShardedTable<GlobalSchema...> parallel_probe_join_table(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const CsrMap<GlobalSchema...>& map,
+        const attr_type<GlobalSchema...>& key_attrs,
+        const attr_type<GlobalSchema...>& row_attrs,
+        const attr_type<GlobalSchema...>& attrs_Y,
+        std::pmr::memory_resource* resource) {
+    ShardedBuffers<HashableRow<GlobalSchema...>> sharded((table.data.size() + MORSEL_SIZE - 1) / MORSEL_SIZE, shard_bits(pool));
+    parallel_probe_join(pool, table, map, key_attrs, row_attrs, attrs_Y,
+        [&sharded](std::size_t morsel, HashableRow<GlobalSchema...>&& join_row) {
+            std::size_t hash = join_row.hash;
+            sharded.push(morsel, hash, std::move(join_row));
+        });
+    ShardedTable<GlobalSchema...> join_table{ShardedRowSet<GlobalSchema...>(shard_bits(pool), resource), row_attrs ^ attrs_Y};
+    merge_sharded_rows(pool, sharded, join_table.data);
+    return join_table;
+}
+
+template<typename TableRows, typename... GlobalSchema>
+ShardedTable<GlobalSchema...> parallel_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const BaseDictionary<GlobalSchema...>& dictionary,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    if (!run_parallel(pool, table.data.size())) {
+        return single_shard(join(table, dictionary, resource));
+    }
+    return parallel_probe_join_table(pool, table, dictionary.construction_map, dictionary.attributes_X, dictionary.attributes_X,
+        dictionary.attributes_Y, resource);
+}
+
+template<typename TableRows, typename... GlobalSchema>
+ShardedTable<GlobalSchema...> parallel_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const ExtendedDictionary<GlobalSchema...>& dictionary,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    if (!run_parallel(pool, table.data.size())) {
+        return single_shard(join(table, dictionary, resource));
+    }
+    return parallel_probe_join_table(pool, table, dictionary.construction_map, dictionary.attributes_X,
+        dictionary.attributes_X ^ dictionary.attributes_Z, dictionary.attributes_Y, resource);
+}
+
+template<typename TableRows, typename... GlobalSchema>
+ShardedTable<GlobalSchema...> parallel_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const Dictionary<GlobalSchema...>& dictionary,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    const auto visitor = [&pool, &table, resource](const auto& dict) { return parallel_join(pool, table, dict, resource); };
+    return std::visit(visitor, dictionary);
+}
+
+// rows of table sharded by the hash of their key_attrs key
+template<typename... GlobalSchema>
+ShardedBuffers<std::pair<key_type<GlobalSchema...>, const HashableRow<GlobalSchema...>*>> shard_by_key(
+        WorkStealingPool& pool,
+        const std::vector<const HashableRow<GlobalSchema...>*>& rows,
+        const attr_type<GlobalSchema...>& key_attrs) {
+    using key = key_type<GlobalSchema...>;
+    ShardedBuffers<std::pair<key, const HashableRow<GlobalSchema...>*>> sharded((rows.size() + MORSEL_SIZE - 1) / MORSEL_SIZE, shard_bits(pool));
+    for_each_morsel(pool, rows.size(), [&](std::size_t morsel, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            key row_key = mask_key<GlobalSchema...>(key_attrs, *rows[i]);
+            std::size_t hash = std::hash<key>{}(row_key);
+            sharded.push(morsel, hash, std::make_pair(std::move(row_key), rows[i]));
+        }
+    });
+    return sharded;
+}
+
+// groups the rows of one shard by key (keys are in exactly one shard)
+template<typename... GlobalSchema>
+std::vector<PartitionRun<GlobalSchema...>> group_shard(
+        ShardedBuffers<std::pair<key_type<GlobalSchema...>, const HashableRow<GlobalSchema...>*>>& sharded,
+        std::size_t shard) {
+    using key = key_type<GlobalSchema...>;
+    absl::flat_hash_map<key, std::size_t, std::hash<key>> run_index;
+    std::vector<PartitionRun<GlobalSchema...>> runs;
+    sharded.drain(shard, [&](std::pair<key, const HashableRow<GlobalSchema...>*>& entry) {
+        auto [it, inserted] = run_index.try_emplace(entry.first, runs.size());
+        if (inserted) {
+            runs.push_back(PartitionRun<GlobalSchema...>{std::move(entry.first), {}});
+        }
+        runs[it->second].rows.push_back(entry.second);
+    });
+    return runs;
+}
+
+// construction
+template<typename TableRows, typename... GlobalSchema>
+Dictionary<GlobalSchema...> parallel_construction(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& attrs_X,
+        const attr_type<GlobalSchema...>& attrs_Y,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    using Row = HashableRow<GlobalSchema...>;
+    if (!run_parallel(pool, table.data.size())) {
+        return construction(table, attrs_X, attrs_Y, resource);
+    }
+    std::vector<const Row*> rows = row_pointers(table);
+    auto sharded = shard_by_key(pool, rows, attrs_X);
+
+    // the Y rows of every key, masked and deduplicated by the shard's task
+    bool distinct_pairs = table.attributes == (attrs_X ^ attrs_Y);
+    std::vector<std::vector<std::pair<key_type<GlobalSchema...>, std::vector<Row>>>> shard_groups(sharded.shard_count());
+    for_each_shard(pool, sharded.shard_count(), [&](std::size_t shard) {
+        RowSet<GlobalSchema...> seen_Y;
+        for (auto& run : group_shard(sharded, shard)) {
+            std::vector<Row> rows_Y;
+            rows_Y.reserve(run.rows.size());
+            seen_Y.clear();
+            for (const Row* row : run.rows) {
+                Row row_Y = mask_row<GlobalSchema...>(attrs_Y, *row);
+                if (distinct_pairs || seen_Y.insert(row_Y).second) {
+                    rows_Y.push_back(std::move(row_Y));
+                }
+            }
+            shard_groups[shard].emplace_back(std::move(run.key_X), std::move(rows_Y));
+        }
+    });
+
+    std::size_t key_count = 0;
+    std::size_t row_count = 0;
+    for (const auto& groups : shard_groups) {
+        key_count += groups.size();
+        for (const auto& group : groups) {
+            row_count += group.second.size();
+        }
+    }
+    BaseDictionary<GlobalSchema...> dict{CsrMap<GlobalSchema...>(resource), attrs_X, attrs_Y};
+    dict.construction_map.reserve(key_count, row_count);
+    for (auto& groups : shard_groups) {
+        for (auto& [group_key, rows_Y] : groups) {
+            dict.construction_map.open_group();
+            for (Row& row_Y : rows_Y) {
+                dict.construction_map.push_row(std::move(row_Y));
+            }
+            dict.construction_map.close_group(group_key);
+        }
+    }
+    return dict;
+}
+
+// group_partitions with the rows grouped by key shard by shard (the runs of a key are in exactly one shard)
+template<typename TableRows, typename... GlobalSchema>
+std::vector<std::vector<PartitionRun<GlobalSchema...>>> parallel_group_partitions(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        const PartitionStrategy& strategy = PartitionStrategy()) {
+    if (!run_parallel(pool, table.data.size())) {
+        return group_partitions(table, partition_attrs, strategy);
+    }
+    std::vector<const HashableRow<GlobalSchema...>*> rows = row_pointers(table);
+    auto sharded = shard_by_key(pool, rows, partition_attrs);
+    std::vector<std::vector<PartitionRun<GlobalSchema...>>> shard_runs(sharded.shard_count());
+    for_each_shard(pool, sharded.shard_count(), [&](std::size_t shard) {
+        shard_runs[shard] = group_shard(sharded, shard);
+    });
+    std::vector<PartitionRun<GlobalSchema...>> runs;
+    for (auto& partial_runs : shard_runs) {
+        std::move(partial_runs.begin(), partial_runs.end(), std::back_inserter(runs));
+    }
+    return assign_partitions(std::move(runs), table.data.size(), strategy);
+}
+
+// partition - the partition tables are built concurrently, so resource must be thread safe
+template<typename TableRows, typename... GlobalSchema>
+std::vector<Table<GlobalSchema...>> parallel_partition(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        const PartitionStrategy& strategy = PartitionStrategy(),
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    if (!run_parallel(pool, table.data.size())) {
+        return partition(table, partition_attrs, strategy, resource);
+    }
+    std::vector<std::vector<PartitionRun<GlobalSchema...>>> partitions = parallel_group_partitions(pool, table, partition_attrs, strategy);
+    std::vector<Table<GlobalSchema...>> partitioned_tables;
+    partitioned_tables.reserve(partitions.size());
+    for (std::size_t i = 0; i < partitions.size(); i++) {
+        partitioned_tables.push_back(Table<GlobalSchema...>{RowSet<GlobalSchema...>(resource), table.attributes});
+    }
+    for_each_shard(pool, partitions.size(), [&](std::size_t i) {
+        for (const auto& run : partitions[i]) {
+            for (const HashableRow<GlobalSchema...>* row : run.rows) {
+                partitioned_tables[i].data.insert(*row);
+            }
+        }
+    });
+    return partitioned_tables;
+}
+
+// union of several row sets into a sharded row set - the rows of the sources are sharded as pointers by their
+// cached hash, and each shard's task inserts its rows into the same shard of rows, so every new row is copied
+// once and nothing is merged afterwards
+// - rows is resharded to the pool's shard count first if it has fewer shards (e.g. a single shard)
+template<typename SourceRows, typename... GlobalSchema>
+void parallel_union(
+        WorkStealingPool& pool,
+        ShardedRowSet<GlobalSchema...>& rows,
+        const std::vector<const SourceRows*>& sources) {
+    using Row = HashableRow<GlobalSchema...>;
+    if (rows.shard_bits() < shard_bits(pool)) {
+        ShardedRowSet<GlobalSchema...> resharded(shard_bits(pool), rows.shard(0).get_allocator().resource());
+        std::vector<const RowSet<GlobalSchema...>*> shards;
+        for (std::size_t shard = 0; shard < rows.shard_count(); shard++) {
+            shards.push_back(&rows.shard(shard));
+        }
+        parallel_union(pool, resharded, shards);
+        rows = std::move(resharded);
+    }
+
+    std::vector<const Row*> source_rows;
+    std::size_t source_count = 0;
+    for (const auto* source : sources) {
+        source_count += source->size();
+    }
+    source_rows.reserve(source_count);
+    for (const auto* source : sources) {
+        for (const Row& row : *source) {
+            source_rows.push_back(&row);
+        }
+    }
+
+    ShardedBuffers<const Row*> sharded((source_rows.size() + MORSEL_SIZE - 1) / MORSEL_SIZE, rows.shard_bits());
+    for_each_morsel(pool, source_rows.size(), [&](std::size_t morsel, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            sharded.push(morsel, source_rows[i]->hash, source_rows[i]);
+        }
+    });
+    for_each_shard(pool, sharded.shard_count(), [&](std::size_t shard) {
+        RowSet<GlobalSchema...>& shard_rows = rows.shard(shard);
+        shard_rows.reserve(shard_rows.size() + sharded.shard_size(shard));
+        sharded.drain(shard, [&](const Row* row) { shard_rows.insert(*row); });
+    });
+}
+
+// in-place union - the added rows are inserted shard by shard, in parallel
+template<typename AddedRows, typename... GlobalSchema>
+void parallel_inplace_union(
+        WorkStealingPool& pool,
+        ShardedTable<GlobalSchema...>& inplace_table,
+        const BasicTable<AddedRows, GlobalSchema...>& added_table) {
+    if (!run_parallel(pool, added_table.data.size())) {
+        inplace_union(inplace_table, added_table);
+        return;
+    }
+    parallel_union(pool, inplace_table.data, std::vector<const AddedRows*>{&added_table.data});
+}
+
+// concurrent outputs - the morsel tasks insert straight into a ConcurrentTable, with no shard buffers and no
+// merge pass (the rows are heap allocated one by one instead, see ConcurrentRowSet)
+template<typename TableRows, typename... GlobalSchema>
+void parallel_project(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& proj_attrs,
+        ConcurrentTable<GlobalSchema...>& proj_table) {
+    std::vector<const HashableRow<GlobalSchema...>*> rows = row_pointers(table);
+    proj_table.attributes = proj_attrs;
+    for_each_morsel(pool, rows.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            proj_table.data.insert(mask_row<GlobalSchema...>(proj_attrs, *rows[i]));
+        }
+    });
+}
+
+template<typename TableRows, typename... GlobalSchema>
+void parallel_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const BaseDictionary<GlobalSchema...>& dictionary,
+        ConcurrentTable<GlobalSchema...>& join_table) {
+    join_table.attributes = dictionary.attributes_X ^ dictionary.attributes_Y;
+    parallel_probe_join(pool, table, dictionary.construction_map, dictionary.attributes_X, dictionary.attributes_X,
+        dictionary.attributes_Y,
+        [&join_table](std::size_t, HashableRow<GlobalSchema...>&& join_row) { join_table.data.insert(std::move(join_row)); });
+}
+
+template<typename TableRows, typename... GlobalSchema>
+void parallel_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const ExtendedDictionary<GlobalSchema...>& dictionary,
+        ConcurrentTable<GlobalSchema...>& join_table) {
+    join_table.attributes = (dictionary.attributes_X ^ dictionary.attributes_Z) ^ dictionary.attributes_Y;
+    parallel_probe_join(pool, table, dictionary.construction_map, dictionary.attributes_X,
+        dictionary.attributes_X ^ dictionary.attributes_Z, dictionary.attributes_Y,
+        [&join_table](std::size_t, HashableRow<GlobalSchema...>&& join_row) { join_table.data.insert(std::move(join_row)); });
+}
+
+template<typename TableRows, typename... GlobalSchema>
+void parallel_join(
+        WorkStealingPool& pool,
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const Dictionary<GlobalSchema...>& dictionary,
+        ConcurrentTable<GlobalSchema...>& join_table) {
+    const auto visitor = [&pool, &table, &join_table](const auto& dict) { parallel_join(pool, table, dict, join_table); };
+    std::visit(visitor, dictionary);
+}
+
+template<typename AddedRows, typename... GlobalSchema>
+void parallel_inplace_union(
+        WorkStealingPool& pool,
+        ConcurrentTable<GlobalSchema...>& inplace_table,
+        const BasicTable<AddedRows, GlobalSchema...>& added_table) {
+    std::vector<const HashableRow<GlobalSchema...>*> rows = row_pointers(added_table);
+    for_each_morsel(pool, rows.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            inplace_table.data.insert(*rows[i]);
+        }
+    });
+}
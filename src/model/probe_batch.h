@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// batched probe/insert kernel shared by the table operators - items are processed PROBE_BATCH_SIZE at a time:
+// the key of every item in the batch is built (hashing it), the hash-table buckets of the whole batch are
+// prefetched, and only then are the probes/inserts run, so the cache misses of a batch overlap instead of
+// being paid one after another
+constexpr std::size_t PROBE_BATCH_SIZE = 32;
+
+// make(item) builds the value for an item, container.prefetch(key_of(value)) is issued for every value of the
+// batch, then apply(value) is called for each value in order (values may be moved from)
+template<typename Container, typename Iterator, typename Make, typename KeyOf, typename Apply>
+void batched_probe(const Container& container, Iterator first, Iterator last, Make&& make, KeyOf&& key_of, Apply&& apply) {
+    using value_type = std::decay_t<decltype(make(*first))>;
+    std::vector<value_type> batch;
+    batch.reserve(PROBE_BATCH_SIZE);
+    while (first != last) {
+        batch.clear();
+        for (; first != last && batch.size() < PROBE_BATCH_SIZE; ++first) {
+            batch.push_back(make(*first));
+            container.prefetch(key_of(batch.back()));
+        }
+        for (value_type& value : batch) {
+            apply(value);
+        }
+    }
+}
+
+// inserts make(item) for every item into set
+template<typename Set, typename Iterator, typename Make>
+void batched_insert(Set& set, Iterator first, Iterator last, Make&& make) {
+    batched_probe(set, first, last, std::forward<Make>(make),
+        [](const auto& value) -> const auto& { return value; },
+        [&set](auto& value) { set.insert(std::move(value)); });
+}
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <array>
-#include <any>
 #include <algorithm>
 #include <bitset>
+#include <iostream>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <utility>
+
+#include "src/model/hash_policy.h"
+#include "src/model/interned_string.h"
 
 template<typename... GlobalSchema>
 using attr_type = typename std::bitset<sizeof...(GlobalSchema)>;
@@ -19,80 +24,83 @@ static attr_type<GlobalSchema...> NULL_ATTR = attr_type<GlobalSchema...>();
 template<std::size_t index, typename... GlobalSchema>
 using elem_type = typename std::tuple_element_t<index, std::tuple<GlobalSchema...>>;
 
-template<std::size_t index, typename... GlobalSchema>
-elem_type<index, GlobalSchema...> safe_get(const std::array<std::any, sizeof...(GlobalSchema)>& data_) {
-    try {
-        return std::any_cast<elem_type<index, GlobalSchema...>>(data_[index]);
-    } catch (const std::bad_any_cast& e) {
-        std::string error_msg = "Bad any cast: ";
-        error_msg += "index=" + std::to_string(index) + " ";
-        error_msg += "expected_type=" + std::string(typeid(elem_type<index, GlobalSchema...>).name()) + " ";
-        error_msg += "actual_type=" + std::string(data_[index].type().name());
-        throw std::runtime_error(error_msg);
-    }
-}
+// typed row layout - one slot per global schema column (absent columns hold a default value)
+template<typename... GlobalSchema>
+using row_data_type = std::tuple<GlobalSchema...>;
 
 template<typename... GlobalSchema>
 struct HashableRow {
     static constexpr std::size_t N = sizeof...(GlobalSchema);
+    using hash_policy = row_hash_policy_t<GlobalSchema...>;
 
-    // TODO: make data reference
-    std::array<std::any, N> data;
+    row_data_type<GlobalSchema...> data;
+    // presence mask - only the columns set here hold a value
+    attr_type<GlobalSchema...> attributes;
+    // cached hash of each present column (0 for absent columns) - masked/joined rows reuse these
+    std::array<std::size_t, N> column_hashes;
     std::size_t hash;
 
-    HashableRow(const std::array<std::any, N>& data_) {
-        data = data_;
-        hash = cache_hash(data_);
+    HashableRow(const row_data_type<GlobalSchema...>& data_, const attr_type<GlobalSchema...>& attributes_)
+        : data(data_), attributes(attributes_) {
+        column_hashes = hash_pack(std::make_index_sequence<N>{});
+        hash = combine_hashes<hash_policy>(column_hashes, attributes);
+    }
+
+    HashableRow(row_data_type<GlobalSchema...>&& data_, const attr_type<GlobalSchema...>& attributes_)
+        : data(std::move(data_)), attributes(attributes_) {
+        column_hashes = hash_pack(std::make_index_sequence<N>{});
+        hash = combine_hashes<hash_policy>(column_hashes, attributes);
     }
-    
+
+    // rows built from columns of existing rows - no column data is rehashed
+    HashableRow(
+        row_data_type<GlobalSchema...>&& data_,
+        const attr_type<GlobalSchema...>& attributes_,
+        const std::array<std::size_t, N>& column_hashes_)
+        : data(std::move(data_)), attributes(attributes_), column_hashes(column_hashes_) {
+        hash = combine_hashes<hash_policy>(column_hashes, attributes);
+    }
+
+    template<std::size_t index>
+    bool has_value() const {
+        return attributes[index];
+    }
+
+    template<std::size_t index>
+    const elem_type<index, GlobalSchema...>& get() const {
+        return std::get<index>(data);
+    }
+
     // == operator
     template<size_t index>
     bool all_eq_idx(const HashableRow& other) const {
-        bool this_has_value = data[index].has_value();
-        bool other_has_value = other.data[index].has_value();
-        if (this_has_value != other_has_value) {
-            return false;
-        }
-        if (this_has_value && other_has_value) {
-            if (safe_get<index, GlobalSchema...>(data) != safe_get<index, GlobalSchema...>(other.data)) {
-                return false;
-            }
-        }
-        return true;
+        return !attributes[index] || std::get<index>(data) == std::get<index>(other.data);
     }
-    
+
     template<std::size_t... Indices>
     bool all_eq_pack(const HashableRow& other, std::index_sequence<Indices...>) const {
-        std::array<bool, N> eq_arr = {all_eq_idx<Indices>(other)...};
-        return std::all_of(eq_arr.begin(), eq_arr.end(), [](bool b){ return b; });
+        return (all_eq_idx<Indices>(other) && ...);
     }
-    
+
     bool operator==(const HashableRow& other) const {
-        return all_eq_pack(other, std::make_index_sequence<N>{});
+        return hash == other.hash
+            && attributes == other.attributes
+            && all_eq_pack(other, std::make_index_sequence<N>{});
     }
 
     // hash
     template<size_t index>
-    std::size_t hash_idx(const std::array<std::any, N>& data_) const {
-        if (data[index].has_value()) {
-            return std::hash<elem_type<index, GlobalSchema...>>{}(safe_get<index, GlobalSchema...>(data_));
+    std::size_t hash_idx() const {
+        if (attributes[index]) {
+            return hash_policy::hash_column(std::get<index>(data));
         } else {
             return 0;
         }
     }
-    
-    template<std::size_t... Indices>
-    std::size_t hash_pack(const std::array<std::any, N>& data_, std::index_sequence<Indices...>) const {
-        std::array<std::size_t, N> seeds = {hash_idx<Indices>(data_)...};
-        std::size_t seed = seeds.size();
-        for (std::size_t i = 0; i < seeds.size(); i++) {
-            seed ^= seeds[i] + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
 
-    std::size_t cache_hash(const std::array<std::any, N>& data_) const {
-        return hash_pack(data_, std::make_index_sequence<N>{});
+    template<std::size_t... Indices>
+    std::array<std::size_t, N> hash_pack(std::index_sequence<Indices...>) const {
+        return {hash_idx<Indices>()...};
     }
 };
 
@@ -104,15 +112,14 @@ struct std::hash<HashableRow<GlobalSchema...>> {
 };
 
 // row mask
-template<typename... GlobalSchema>
-std::any mask_row_idx(
+template<std::size_t index, typename... GlobalSchema>
+elem_type<index, GlobalSchema...> mask_row_idx(
         const attr_type<GlobalSchema...>& attributes,
-        const HashableRow<GlobalSchema...>& row,
-        std::size_t index) {
+        const HashableRow<GlobalSchema...>& row) {
     if (attributes[index]) {
-        return row.data[index];
+        return std::get<index>(row.data);
     } else {
-        return std::any();
+        return elem_type<index, GlobalSchema...>();
     }
 }
 
@@ -121,8 +128,9 @@ HashableRow<GlobalSchema...> mask_row_pack(
         const attr_type<GlobalSchema...>& attributes,
         const HashableRow<GlobalSchema...>& row,
         std::index_sequence<Indices...>) {
-    std::array<std::any, sizeof...(GlobalSchema)> data = {mask_row_idx<GlobalSchema...>(attributes, row, Indices)...};
-    HashableRow<GlobalSchema...> proj_row = HashableRow<GlobalSchema...>(data);
+    row_data_type<GlobalSchema...> data = {mask_row_idx<Indices, GlobalSchema...>(attributes, row)...};
+    std::array<std::size_t, sizeof...(GlobalSchema)> column_hashes = {(attributes[Indices] ? row.column_hashes[Indices] : 0)...};
+    HashableRow<GlobalSchema...> proj_row = HashableRow<GlobalSchema...>(std::move(data), attributes & row.attributes, column_hashes);
     return proj_row;
 }
 
@@ -134,19 +142,18 @@ HashableRow<GlobalSchema...> mask_row(
 }
 
 // row merge
-template<typename... GlobalSchema>
-std::any join_rows_idx(
+template<std::size_t index, typename... GlobalSchema>
+elem_type<index, GlobalSchema...> join_rows_idx(
         const HashableRow<GlobalSchema...>& row_X, 
         const HashableRow<GlobalSchema...>& row_Y, 
         const attr_type<GlobalSchema...>& attributes_X, 
-        const attr_type<GlobalSchema...>& attributes_Y,
-        std::size_t index) {
+        const attr_type<GlobalSchema...>& attributes_Y) {
     if (attributes_X[index]) {
-        return row_X.data[index];
+        return std::get<index>(row_X.data);
     } else if (attributes_Y[index]) {
-        return row_Y.data[index];
+        return std::get<index>(row_Y.data);
     } else {
-        return std::any();
+        return elem_type<index, GlobalSchema...>();
     }
 }
 
@@ -157,9 +164,14 @@ HashableRow<GlobalSchema...> join_rows_pack(
         const attr_type<GlobalSchema...>& attributes_X, 
         const attr_type<GlobalSchema...>& attributes_Y,
         std::index_sequence<Indices...>) {
-    std::array<std::any, sizeof...(GlobalSchema)> data = 
-        {join_rows_idx<GlobalSchema...>(row_X, row_Y, attributes_X, attributes_Y, Indices)...};
-    HashableRow<GlobalSchema...> join_row = HashableRow<GlobalSchema...>(data);
+    row_data_type<GlobalSchema...> data = 
+        {join_rows_idx<Indices, GlobalSchema...>(row_X, row_Y, attributes_X, attributes_Y)...};
+    std::array<std::size_t, sizeof...(GlobalSchema)> column_hashes = {
+        (attributes_X[Indices] ? row_X.column_hashes[Indices] : (attributes_Y[Indices] ? row_Y.column_hashes[Indices] : 0))...
+    };
+    const attr_type<GlobalSchema...> attributes =
+        (attributes_X & row_X.attributes) | (~attributes_X & attributes_Y & row_Y.attributes);
+    HashableRow<GlobalSchema...> join_row = HashableRow<GlobalSchema...>(std::move(data), attributes, column_hashes);
     return join_row;
 }
 
@@ -176,8 +188,8 @@ HashableRow<GlobalSchema...> join_rows(
 template<std::size_t index, typename... GlobalSchema>
 std::string print_idx(const HashableRow<GlobalSchema...>& row) {
     std::stringstream ss;
-    if (row.data[index].has_value()) {
-        ss << safe_get<index, GlobalSchema...>(row.data);
+    if (row.template has_value<index>()) {
+        ss << row.template get<index>();
     } else {
         ss << "null";
     }
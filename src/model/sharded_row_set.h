@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "src/model/row.h"
+#include "src/model/table.h"
+
+// row set split into shards by the cached row hash (see radix_partition), each shard a RowSet of its own
+// - a row can only be in its hash's shard, so shards are disjoint and different shards can be filled by
+//   different threads at once with no merge pass afterwards (e.g. one task per shard, see parallel_table.h)
+// - a set with a single shard is a plain RowSet, so a sequential operator's output is moved in whole
+// - inserts through the set itself (and every read) follow the RowSet rules - one thread at a time
+template<typename... GlobalSchema>
+class ShardedRowSet {
+public:
+    using row_type = HashableRow<GlobalSchema...>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = row_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const row_type*;
+        using reference = const row_type&;
+
+        const_iterator(const std::vector<RowSet<GlobalSchema...>>* shards_, std::size_t shard_)
+            : shards(shards_), shard(shard_) {
+            if (shard < shards->size()) {
+                it = (*shards)[shard].begin();
+                skip_empty();
+            }
+        }
+
+        const row_type& operator*() const {
+            return *it;
+        }
+
+        const row_type* operator->() const {
+            return &*it;
+        }
+
+        const_iterator& operator++() {
+            ++it;
+            skip_empty();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return shard == other.shard && (shard == shards->size() || it == other.it);
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const std::vector<RowSet<GlobalSchema...>>* shards;
+        std::size_t shard;
+        typename RowSet<GlobalSchema...>::const_iterator it;
+
+        void skip_empty() {
+            while (it == (*shards)[shard].end()) {
+                if (++shard == shards->size()) {
+                    return;
+                }
+                it = (*shards)[shard].begin();
+            }
+        }
+    };
+
+    explicit ShardedRowSet(unsigned bits_ = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : bits(bits_) {
+        shards.reserve(shard_count());
+        for (std::size_t shard = 0; shard < shard_count(); shard++) {
+            shards.emplace_back(resource);
+        }
+    }
+
+    ShardedRowSet(RowSet<GlobalSchema...> rows) : bits(0) {
+        shards.push_back(std::move(rows));
+    }
+
+    unsigned shard_bits() const {
+        return bits;
+    }
+
+    std::size_t shard_count() const {
+        return std::size_t(1) << bits;
+    }
+
+    std::size_t shard_of(std::size_t hash) const {
+        return bits == 0 ? 0 : radix_partition(hash, bits);
+    }
+
+    RowSet<GlobalSchema...>& shard(std::size_t shard_) {
+        return shards[shard_];
+    }
+
+    const RowSet<GlobalSchema...>& shard(std::size_t shard_) const {
+        return shards[shard_];
+    }
+
+    std::pair<typename RowSet<GlobalSchema...>::iterator, bool> insert(row_type row) {
+        return shards[shard_of(row.hash)].insert(std::move(row));
+    }
+
+    bool contains(const row_type& row) const {
+        return shards[shard_of(row.hash)].contains(row);
+    }
+
+    std::size_t count(const row_type& row) const {
+        return contains(row);
+    }
+
+    void prefetch(const row_type& row) const {
+        shards[shard_of(row.hash)].prefetch(row);
+    }
+
+    // row_count rows in total, spread evenly over the shards
+    void reserve(std::size_t row_count) {
+        for (auto& rows : shards) {
+            rows.reserve((row_count >> bits) + 1);
+        }
+    }
+
+    std::size_t size() const {
+        std::size_t row_count = 0;
+        for (const auto& rows : shards) {
+            row_count += rows.size();
+        }
+        return row_count;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(&shards, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(&shards, shards.size());
+    }
+
+    // same rows, whatever the shard counts
+    bool operator==(const ShardedRowSet& other) const {
+        if (size() != other.size()) {
+            return false;
+        }
+        for (const row_type& row : *this) {
+            if (!other.contains(row)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const ShardedRowSet& other) const {
+        return !(*this == other);
+    }
+
+private:
+    unsigned bits;
+    std::vector<RowSet<GlobalSchema...>> shards;
+};
+
+template<typename... GlobalSchema>
+using ShardedTable = BasicTable<ShardedRowSet<GlobalSchema...>, GlobalSchema...>;
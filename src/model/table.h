@@ -6,25 +6,58 @@
 #include <unordered_map>
 #include <array>
 #include <unordered_set>
-#include <any>
 #include <utility>
 #include <bitset>
 #include <cmath>
 #include <iostream>
+#include <memory_resource>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+
+#include "src/model/concurrent_row_set.h"
+#include "src/model/csr_map.h"
+#include "src/model/packed_key.h"
+#include "src/model/probe_batch.h"
 #include "src/model/row.h"
 
-// model
+// row containers - open addressing tables keyed by the cached row/key hash
+// - memory comes from a std::pmr memory resource (the global heap unless an arena is passed to the operator)
+// - copies are made on the default resource, moves keep the source resource
+template<typename... GlobalSchema>
+using RowSet = absl::flat_hash_set<
+    HashableRow<GlobalSchema...>,
+    std::hash<HashableRow<GlobalSchema...>>,
+    std::equal_to<HashableRow<GlobalSchema...>>,
+    std::pmr::polymorphic_allocator<HashableRow<GlobalSchema...>>>;
+
 template<typename... GlobalSchema>
-struct Table {
-    std::unordered_set<HashableRow<GlobalSchema...>> data;
+using RowMap = absl::flat_hash_map<
+    key_type<GlobalSchema...>,
+    RowSet<GlobalSchema...>,
+    std::hash<key_type<GlobalSchema...>>,
+    std::equal_to<key_type<GlobalSchema...>>,
+    std::pmr::polymorphic_allocator<std::pair<const key_type<GlobalSchema...>, RowSet<GlobalSchema...>>>>;
+
+// model - a table is a row set over attributes, and the row set is its backend (a RowSet, a ConcurrentRowSet
+// when several threads insert into one table, or a ShardedRowSet when each thread fills its own shards, see
+// sharded_row_set.h) - the operators read tables of any backend
+template<typename TableRows, typename... GlobalSchema>
+struct BasicTable {
+    TableRows data;
     attr_type<GlobalSchema...> attributes;
 };
 
+template<typename... GlobalSchema>
+using Table = BasicTable<RowSet<GlobalSchema...>, GlobalSchema...>;
+
+template<typename... GlobalSchema>
+using ConcurrentTable = BasicTable<ConcurrentRowSet<GlobalSchema...>, GlobalSchema...>;
+
 template<typename... GlobalSchema>
 struct BaseDictionary {
     // X -> Y
-    std::unordered_map<HashableRow<GlobalSchema...>, std::unordered_set<HashableRow<GlobalSchema...>>> construction_map;
+    CsrMap<GlobalSchema...> construction_map;
     attr_type<GlobalSchema...> attributes_X;
     attr_type<GlobalSchema...> attributes_Y;
 };
@@ -32,7 +65,7 @@ struct BaseDictionary {
 template<typename... GlobalSchema>
 struct ExtendedDictionary {
     // XZ -> Y
-    std::unordered_map<HashableRow<GlobalSchema...>, std::unordered_set<HashableRow<GlobalSchema...>>> construction_map;
+    CsrMap<GlobalSchema...> construction_map;
     attr_type<GlobalSchema...> attributes_X;
     attr_type<GlobalSchema...> attributes_Y;
     attr_type<GlobalSchema...> attributes_Z;
@@ -42,89 +75,165 @@ template<typename... GlobalSchema>
 using Dictionary = std::variant<BaseDictionary<GlobalSchema...>, ExtendedDictionary<GlobalSchema...>>;
 
 // projection
-template<typename... GlobalSchema>
+template<typename TableRows, typename... GlobalSchema>
 Table<GlobalSchema...> project(
-        const Table<GlobalSchema...>& table,
-        const attr_type<GlobalSchema...>& proj_attrs) {
-    Table<GlobalSchema...> proj_table;
-    proj_table.attributes = proj_attrs;
-    proj_table.data = {};
-    for (const HashableRow<GlobalSchema...>& row : table.data) {
-        HashableRow<GlobalSchema...> proj_row = mask_row<GlobalSchema...>(proj_attrs, row);
-        proj_table.data.insert(proj_row);
-    }
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& proj_attrs,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    Table<GlobalSchema...> proj_table{RowSet<GlobalSchema...>(resource), proj_attrs};
+    proj_table.data.reserve(table.data.size());
+    batched_insert(proj_table.data, table.data.begin(), table.data.end(), [&proj_attrs](const HashableRow<GlobalSchema...>& row) {
+        return mask_row<GlobalSchema...>(proj_attrs, row);
+    });
     return proj_table;
 }
 
 // join
-template<typename... GlobalSchema>
+// radix partitioning is used once both sides exceed this many rows / keys - below it the dictionary index is
+// small enough to stay cache resident and probes go straight to it
+constexpr std::size_t RADIX_JOIN_MIN_SIZE = 1 << 16;
+// target number of dictionary keys per radix partition (so a partition's index fits in L2)
+constexpr std::size_t RADIX_JOIN_PARTITION_KEYS = 1 << 12;
+
+template<typename TableRows, typename... GlobalSchema>
+unsigned radix_join_bits(const BasicTable<TableRows, GlobalSchema...>& table, const CsrMap<GlobalSchema...>& map) {
+    if (table.data.size() < RADIX_JOIN_MIN_SIZE || map.size() < RADIX_JOIN_MIN_SIZE) {
+        return 0;
+    }
+    return std::min<unsigned>(std::ceil(log2(map.size() / RADIX_JOIN_PARTITION_KEYS)), 12);
+}
+
+// partition of a key hash - the top bits of a multiplicative mix (the hash-table index uses the low bits)
+inline std::size_t radix_partition(std::size_t hash, unsigned radix_bits) {
+    return static_cast<std::size_t>((static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL) >> (64 - radix_bits));
+}
+
+// probes map with the key_attrs of each row of table and inserts join_rows(row, row_Y, row_attrs, attrs_Y)
+// for each match
+// - radix_bits == 0: every probe goes to the dictionary index
+// - radix_bits > 0: probe rows and dictionary keys are scattered into 2^radix_bits partitions by key hash, and
+//   each partition is joined against a small index of its own keys
+template<typename TableRows, typename... GlobalSchema>
+void probe_join(
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const CsrMap<GlobalSchema...>& map,
+        const attr_type<GlobalSchema...>& key_attrs,
+        const attr_type<GlobalSchema...>& row_attrs,
+        const attr_type<GlobalSchema...>& attrs_Y,
+        unsigned radix_bits,
+        Table<GlobalSchema...>& join_table) {
+    using key = key_type<GlobalSchema...>;
+    using Rows = typename CsrMap<GlobalSchema...>::Rows;
+    using Probe = std::pair<key, const HashableRow<GlobalSchema...>*>;
+    auto make_probe = [&key_attrs](const HashableRow<GlobalSchema...>& row) {
+        return Probe(mask_key<GlobalSchema...>(key_attrs, row), &row);
+    };
+    auto probe_key = [](const Probe& probe) -> const key& { return probe.first; };
+    if (radix_bits == 0) {
+        batched_probe(map, table.data.begin(), table.data.end(), make_probe, probe_key, [&](const Probe& probe) {
+            for (const HashableRow<GlobalSchema...>& row_Y : map.find(probe.first)) {
+                join_table.data.insert(join_rows<GlobalSchema...>(*probe.second, row_Y, row_attrs, attrs_Y));
+            }
+        });
+        return;
+    }
+
+    std::size_t partition_count = std::size_t(1) << radix_bits;
+    std::vector<std::vector<std::pair<key, const HashableRow<GlobalSchema...>*>>> probe_partitions(partition_count);
+    for (auto& probe_partition : probe_partitions) {
+        probe_partition.reserve(table.data.size() / partition_count + 1);
+    }
+    for (const HashableRow<GlobalSchema...>& row : table.data) {
+        key row_key = mask_key<GlobalSchema...>(key_attrs, row);
+        std::size_t hash = std::hash<key>{}(row_key);
+        probe_partitions[radix_partition(hash, radix_bits)].emplace_back(std::move(row_key), &row);
+    }
+    std::vector<std::vector<std::pair<const key*, Rows>>> build_partitions(partition_count);
+    for (auto& build_partition : build_partitions) {
+        build_partition.reserve(map.size() / partition_count + 1);
+    }
+    for (const auto& [map_key, rows] : map) {
+        build_partitions[radix_partition(std::hash<key>{}(map_key), radix_bits)].emplace_back(&map_key, rows);
+    }
+
+    auto key_hash = [](const key* k) { return std::hash<key>{}(*k); };
+    auto key_eq = [](const key* k_1, const key* k_2) { return *k_1 == *k_2; };
+    absl::flat_hash_map<const key*, Rows, decltype(key_hash), decltype(key_eq)> partition_index(0, key_hash, key_eq);
+    for (std::size_t p = 0; p < partition_count; p++) {
+        if (probe_partitions[p].empty() || build_partitions[p].empty()) {
+            continue;
+        }
+        partition_index.clear();
+        partition_index.insert(build_partitions[p].begin(), build_partitions[p].end());
+        batched_probe(partition_index, probe_partitions[p].begin(), probe_partitions[p].end(),
+            [](const Probe& probe) { return &probe; },
+            [](const Probe* probe) { return &probe->first; },
+            [&](const Probe* probe) {
+                auto it = partition_index.find(&probe->first);
+                if (it == partition_index.end()) {
+                    return;
+                }
+                for (const HashableRow<GlobalSchema...>& row_Y : it->second) {
+                    join_table.data.insert(join_rows<GlobalSchema...>(*probe->second, row_Y, row_attrs, attrs_Y));
+                }
+            });
+    }
+}
+
+template<typename TableRows, typename... GlobalSchema>
 Table<GlobalSchema...> join(
-        const Table<GlobalSchema...>& table,
-        const BaseDictionary<GlobalSchema...>& dictionary) {
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const BaseDictionary<GlobalSchema...>& dictionary,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
 
     // TODO: add runtime precondition that overlap_attrs == 0
     const attr_type<GlobalSchema...> join_attrs = dictionary.attributes_X ^ dictionary.attributes_Y;
     const attr_type<GlobalSchema...> overlap_attrs = dictionary.attributes_X & dictionary.attributes_Y;
 
-    Table<GlobalSchema...> join_table;
-    join_table.attributes = join_attrs;
-    join_table.data = {};
-    for (const HashableRow<GlobalSchema...>& row_X : table.data) {
-        if (dictionary.construction_map.count(row_X) > 0) {
-            for (const HashableRow<GlobalSchema...>& row_Y : dictionary.construction_map.at(row_X)) {
-                HashableRow<GlobalSchema...> join_row = 
-                    join_rows<GlobalSchema...>(row_X, row_Y, dictionary.attributes_X, dictionary.attributes_Y);
-                join_table.data.insert(join_row);
-            }
-        }
-    }
+    Table<GlobalSchema...> join_table{RowSet<GlobalSchema...>(resource), join_attrs};
+    probe_join(table, dictionary.construction_map, dictionary.attributes_X, dictionary.attributes_X, dictionary.attributes_Y,
+        radix_join_bits(table, dictionary.construction_map), join_table);
     return join_table;
 }
 
-template<typename... GlobalSchema>
+template<typename TableRows, typename... GlobalSchema>
 Table<GlobalSchema...> join(
-        const Table<GlobalSchema...>& table,
-        const ExtendedDictionary<GlobalSchema...>& dictionary) {
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const ExtendedDictionary<GlobalSchema...>& dictionary,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
 
     // TODO: add runtime precondition that overlap_attrs == 0
     const attr_type<GlobalSchema...> join_attrs = (dictionary.attributes_X ^ dictionary.attributes_Z) ^ dictionary.attributes_Y;
     const attr_type<GlobalSchema...> overlap_attrs = (dictionary.attributes_X & dictionary.attributes_Z) & dictionary.attributes_Y;
 
-    Table<GlobalSchema...> join_table;
-    join_table.attributes = join_attrs;
-    join_table.data = {};
-    for (const HashableRow<GlobalSchema...>& row_XZ : table.data) {
-        HashableRow<GlobalSchema...> row_X = mask_row<GlobalSchema...>(dictionary.attributes_X, row_XZ);
-        if (dictionary.construction_map.count(row_X) > 0) {
-            for (const HashableRow<GlobalSchema...>& row_Y : dictionary.construction_map.at(row_X)) {
-                HashableRow<GlobalSchema...> join_row = 
-                    join_rows<GlobalSchema...>(row_XZ, row_Y, (dictionary.attributes_X ^ dictionary.attributes_Z), dictionary.attributes_Y);
-                join_table.data.insert(join_row);
-            }
-        }
-    }
+    Table<GlobalSchema...> join_table{RowSet<GlobalSchema...>(resource), join_attrs};
+    probe_join(table, dictionary.construction_map, dictionary.attributes_X, dictionary.attributes_X ^ dictionary.attributes_Z,
+        dictionary.attributes_Y, radix_join_bits(table, dictionary.construction_map), join_table);
     return join_table;
 }
 
-template<typename... GlobalSchema>
+template<typename TableRows, typename... GlobalSchema>
 Table<GlobalSchema...> join(
-        const Table<GlobalSchema...>& table,
-        const Dictionary<GlobalSchema...>& dictionary) {
-    const auto visitor = [table](const auto& dict){ return join(table, dict); };
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const Dictionary<GlobalSchema...>& dictionary,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    const auto visitor = [&table, resource](const auto& dict){ return join(table, dict, resource); };
     return std::visit(visitor, dictionary);
 }
 
-// extension
+// extension - the extended dictionary shares the construction map of dictionary in O(1) when its storage is heap
+// allocated or already allocated from resource, and gets a copy in resource otherwise (see CsrMap)
 template<typename... GlobalSchema>
 ExtendedDictionary<GlobalSchema...> extension(
         const BaseDictionary<GlobalSchema...>& dictionary,
-        const attr_type<GlobalSchema...>& ext_attrs) {
+        const attr_type<GlobalSchema...>& ext_attrs,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
 
     // TODO: add runtime precondition that overlap_attrs == 0
     const attr_type<GlobalSchema...> overlap_attrs = ext_attrs | (dictionary.attributes_X | dictionary.attributes_Y);
 
     return ExtendedDictionary<GlobalSchema...>{
-        dictionary.construction_map,
+        dictionary.construction_map.copy_to(resource),
         dictionary.attributes_X,
         dictionary.attributes_Y,
         ext_attrs
@@ -134,13 +243,14 @@ ExtendedDictionary<GlobalSchema...> extension(
 template<typename... GlobalSchema>
 ExtendedDictionary<GlobalSchema...> extension(
         const ExtendedDictionary<GlobalSchema...>& dictionary,
-        const attr_type<GlobalSchema...>& ext_attrs) {
+        const attr_type<GlobalSchema...>& ext_attrs,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
 
     // TODO: add runtime precondition that overlap_attrs == 0
     const attr_type<GlobalSchema...> overlap_attrs = ext_attrs & ((dictionary.attributes_X & dictionary.attributes_Z) & dictionary.attributes_Y);
 
     return ExtendedDictionary<GlobalSchema...>{
-        dictionary.construction_map,
+        dictionary.construction_map.copy_to(resource),
         dictionary.attributes_X,
         dictionary.attributes_Y,
         ext_attrs ^ dictionary.attributes_Z
@@ -150,17 +260,19 @@ ExtendedDictionary<GlobalSchema...> extension(
 template<typename... GlobalSchema>
 Dictionary<GlobalSchema...> extension(
         const Dictionary<GlobalSchema...>& dictionary,
-        const attr_type<GlobalSchema...>& ext_attrs) {
-    const auto visitor = [ext_attrs](const auto& dict){ return extension(dict, ext_attrs); };
+        const attr_type<GlobalSchema...>& ext_attrs,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    const auto visitor = [&ext_attrs, resource](const auto& dict){ return Dictionary<GlobalSchema...>(extension(dict, ext_attrs, resource)); };
     return std::visit(visitor, dictionary);
 }
 
 // construction
-template<typename... GlobalSchema>
+template<typename TableRows, typename... GlobalSchema>
 Dictionary<GlobalSchema...> construction(
-        const Table<GlobalSchema...>& table,
+        const BasicTable<TableRows, GlobalSchema...>& table,
         const attr_type<GlobalSchema...>& attrs_X,
-        const attr_type<GlobalSchema...>& attrs_Y) {
+        const attr_type<GlobalSchema...>& attrs_Y,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
 
     // TODO: add runtime precondition that overlap_attrs == 0
     const attr_type<GlobalSchema...> overlap_attrs = attrs_X | attrs_Y;
@@ -168,95 +280,280 @@ Dictionary<GlobalSchema...> construction(
     // TODO: add runtime precondition that join_attrs = table attrs
     const attr_type<GlobalSchema...> join_attrs = attrs_X ^ attrs_Y;
 
-    BaseDictionary<GlobalSchema...> dict;
-    dict.attributes_X = attrs_X;
-    dict.attributes_Y = attrs_Y;
-    dict.construction_map = {};
+    // counting sort of the rows by X key, then one Y row per (X, Y) pair is appended key by key
+    absl::flat_hash_map<key_type<GlobalSchema...>, std::size_t, std::hash<key_type<GlobalSchema...>>> key_slots;
+    std::vector<std::size_t> row_slots;
+    std::vector<std::size_t> slot_offsets;
+    std::vector<const key_type<GlobalSchema...>*> slot_keys;
+    row_slots.reserve(table.data.size());
+    batched_probe(key_slots, table.data.begin(), table.data.end(),
+        [&attrs_X](const HashableRow<GlobalSchema...>& row) { return mask_key<GlobalSchema...>(attrs_X, row); },
+        [](const key_type<GlobalSchema...>& key) -> const key_type<GlobalSchema...>& { return key; },
+        [&](key_type<GlobalSchema...>& key) {
+            auto [it, inserted] = key_slots.try_emplace(std::move(key), slot_offsets.size());
+            if (inserted) {
+                slot_offsets.push_back(0);
+            }
+            slot_offsets[it->second]++;
+            row_slots.push_back(it->second);
+        });
+    slot_keys.resize(slot_offsets.size());
+    for (const auto& [key, slot] : key_slots) {
+        slot_keys[slot] = &key;
+    }
+    std::size_t offset = 0;
+    for (std::size_t& slot_offset : slot_offsets) {
+        std::swap(offset, slot_offset);
+        offset += slot_offset;
+    }
+    std::vector<std::size_t> slot_ends = slot_offsets;
+    std::vector<const HashableRow<GlobalSchema...>*> sorted_rows(table.data.size());
+    std::size_t i = 0;
     for (const HashableRow<GlobalSchema...>& row : table.data) {
-        HashableRow<GlobalSchema...> row_X = mask_row<GlobalSchema...>(attrs_X, row);
-        HashableRow<GlobalSchema...> row_Y = mask_row<GlobalSchema...>(attrs_Y, row);
-        if (dict.construction_map.count(row_X) == 0) {
-            dict.construction_map[row_X] = {};
+        sorted_rows[slot_ends[row_slots[i++]]++] = &row;
+    }
+
+    // rows of a table over exactly XY are distinct pairs, otherwise Y rows are deduplicated per key
+    bool distinct_pairs = table.attributes == join_attrs;
+    RowSet<GlobalSchema...> seen_Y;
+    BaseDictionary<GlobalSchema...> dict{CsrMap<GlobalSchema...>(resource), attrs_X, attrs_Y};
+    dict.construction_map.reserve(slot_keys.size(), table.data.size());
+    for (std::size_t slot = 0; slot < slot_keys.size(); slot++) {
+        dict.construction_map.open_group();
+        seen_Y.clear();
+        for (std::size_t j = slot_offsets[slot]; j < slot_ends[slot]; j++) {
+            HashableRow<GlobalSchema...> row_Y = mask_row<GlobalSchema...>(attrs_Y, *sorted_rows[j]);
+            if (distinct_pairs || seen_Y.insert(row_Y).second) {
+                dict.construction_map.push_row(std::move(row_Y));
+            }
         }
-        dict.construction_map[row_X].insert(row_Y);
+        dict.construction_map.close_group(*slot_keys[slot]);
     }
     return dict;
 }
 
+// partition strategy - how the rows of a table are grouped by the degree of their partition attributes X
+// - LOG_DEGREE: one class per class_width powers of two of the degree
+// - HEAVY_LIGHT: two classes, X values with degree above heavy_degree (sqrt of the table size if 0) and the rest
+// classes below coalesce_rows rows are merged into the next class, and with split_classes each class is split
+// round-robin into two tables (so each X value is in at most two tables)
+enum class PartitionMode {
+    LOG_DEGREE,
+    HEAVY_LIGHT,
+};
+
+struct PartitionStrategy {
+    PartitionMode mode = PartitionMode::LOG_DEGREE;
+    unsigned class_width = 1;
+    std::size_t heavy_degree = 0;
+    std::size_t coalesce_rows = 0;
+    bool split_classes = true;
+};
+
 // partition
+// rows of one X value assigned to one partition
 template<typename... GlobalSchema>
-std::vector<Table<GlobalSchema...>> partition(
-        const Table<GlobalSchema...>& table,
-        const attr_type<GlobalSchema...>& partition_attrs) {
-    std::unordered_map<HashableRow<GlobalSchema...>, std::unordered_set<HashableRow<GlobalSchema...>>> row_X_to_rows;
-    for (const HashableRow<GlobalSchema...>& row : table.data) {
-        HashableRow<GlobalSchema...> row_X = mask_row<GlobalSchema...>(partition_attrs, row);
-        if (row_X_to_rows.count(row_X) == 0) {
-            row_X_to_rows[row_X] = {};
+struct PartitionRun {
+    key_type<GlobalSchema...> key_X;
+    std::vector<const HashableRow<GlobalSchema...>*> rows;
+};
+
+template<typename Run>
+std::vector<std::vector<Run>> assign_partitions(
+        std::vector<Run> runs,
+        std::size_t row_count,
+        const PartitionStrategy& strategy);
+
+// groups the rows of table by X once and assigns them to partitions - each partition lists one run per X value
+// (the rows stay owned by table)
+template<typename TableRows, typename... GlobalSchema>
+std::vector<std::vector<PartitionRun<GlobalSchema...>>> group_partitions(
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        const PartitionStrategy& strategy) {
+    using Run = PartitionRun<GlobalSchema...>;
+    std::vector<std::vector<Run>> partitions;
+    if (table.data.empty()) {
+        return partitions;
+    }
+
+    absl::flat_hash_map<key_type<GlobalSchema...>, std::vector<const HashableRow<GlobalSchema...>*>, std::hash<key_type<GlobalSchema...>>> row_X_to_rows;
+    using Probe = std::pair<key_type<GlobalSchema...>, const HashableRow<GlobalSchema...>*>;
+    batched_probe(row_X_to_rows, table.data.begin(), table.data.end(),
+        [&partition_attrs](const HashableRow<GlobalSchema...>& row) { return Probe(mask_key<GlobalSchema...>(partition_attrs, row), &row); },
+        [](const Probe& probe) -> const key_type<GlobalSchema...>& { return probe.first; },
+        [&row_X_to_rows](Probe& probe) { row_X_to_rows[std::move(probe.first)].push_back(probe.second); });
+
+    std::vector<Run> runs;
+    runs.reserve(row_X_to_rows.size());
+    for (auto& [row_X, rows] : row_X_to_rows) {
+        runs.push_back(Run{row_X, std::move(rows)});
+    }
+    return assign_partitions(std::move(runs), table.data.size(), strategy);
+}
+
+// assigns the runs of every X value (row_count rows in total) to partitions
+// - Run is any run with a key_X and a vector of rows (e.g. PartitionRun, or row indices of a columnar table)
+template<typename Run>
+std::vector<std::vector<Run>> assign_partitions(
+        std::vector<Run> runs,
+        std::size_t row_count,
+        const PartitionStrategy& strategy) {
+    std::vector<std::vector<Run>> partitions;
+    if (row_count == 0) {
+        return partitions;
+    }
+
+    std::size_t heavy_degree = strategy.heavy_degree > 0 ? strategy.heavy_degree : std::sqrt(row_count);
+    unsigned class_width = std::max(strategy.class_width, 1u);
+    unsigned class_count = strategy.mode == PartitionMode::HEAVY_LIGHT
+        ? 2
+        : static_cast<unsigned>(std::ceil(log2(row_count))) / class_width + 1;
+    // runs of each class and the number of rows in them
+    std::vector<std::pair<std::vector<Run*>, std::size_t>> partitioned_runs(class_count);
+    for (Run& run : runs) {
+        unsigned degree_class = strategy.mode == PartitionMode::HEAVY_LIGHT
+            ? run.rows.size() > heavy_degree
+            : static_cast<unsigned>(std::ceil(log2(run.rows.size()))) / class_width;
+        partitioned_runs[degree_class].first.push_back(&run);
+        partitioned_runs[degree_class].second += run.rows.size();
+    }
+
+    // merge classes up to the row threshold - the last class absorbs any remainder
+    std::vector<std::pair<std::vector<Run*>, std::size_t>> classes;
+    for (auto& class_runs : partitioned_runs) {
+        if (class_runs.first.empty()) {
+            continue;
+        }
+        if (classes.empty() || classes.back().second >= strategy.coalesce_rows) {
+            classes.push_back(std::move(class_runs));
+        } else {
+            classes.back().first.insert(classes.back().first.end(), class_runs.first.begin(), class_runs.first.end());
+            classes.back().second += class_runs.second;
         }
-        row_X_to_rows[row_X].insert(row);
     }
-    unsigned bucket_count = 2 * std::ceil(log2(table.data.size())) + 1;
-    std::vector<std::vector<HashableRow<GlobalSchema...>>> partitioned_rows(bucket_count);
-    for (const auto& [row_X, rows] : row_X_to_rows) {
-        unsigned log_degree = std::ceil(log2(rows.size()));
-        for (const HashableRow<GlobalSchema...>& row : rows) {
-            partitioned_rows[log_degree].push_back(row);
+    if (classes.size() > 1 && classes.back().second < strategy.coalesce_rows) {
+        auto remainder = std::move(classes.back());
+        classes.pop_back();
+        classes.back().first.insert(classes.back().first.end(), remainder.first.begin(), remainder.first.end());
+        classes.back().second += remainder.second;
+    }
+
+    // round-robin over the rows of each class, so a run is split between at most two partitions
+    for (const auto& [class_runs, class_rows] : classes) {
+        std::size_t table_count = strategy.split_classes && class_rows > 1 ? 2 : 1;
+        std::size_t first = partitions.size();
+        partitions.resize(first + table_count);
+        std::size_t j = 0;
+        for (Run* run : class_runs) {
+            std::array<Run*, 2> split_runs = {nullptr, nullptr};
+            for (const auto& row : run->rows) {
+                std::size_t target = j++ % table_count;
+                if (!split_runs[target]) {
+                    partitions[first + target].push_back(Run{run->key_X, {}});
+                    split_runs[target] = &partitions[first + target].back();
+                }
+                split_runs[target]->rows.push_back(row);
+            }
         }
     }
+    return partitions;
+}
+
+template<typename TableRows, typename... GlobalSchema>
+std::vector<Table<GlobalSchema...>> partition(
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        const PartitionStrategy& strategy,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
     std::vector<Table<GlobalSchema...>> partitioned_tables;
-    for (std::size_t i = 0; i < bucket_count; i++) {
-        Table<GlobalSchema...> partitioned_table1;
-        Table<GlobalSchema...> partitioned_table2;
-        partitioned_table1.attributes = table.attributes;
-        partitioned_table2.attributes = table.attributes;
-        partitioned_table1.data = {};
-        partitioned_table2.data = {};
-        for (std::size_t j = 0; j < partitioned_rows[i].size(); j++) {
-            if (j % 2 == 0) {
-                partitioned_table1.data.insert(partitioned_rows[i][j]);
-            } else {
-                partitioned_table2.data.insert(partitioned_rows[i][j]);
+    for (const auto& runs : group_partitions(table, partition_attrs, strategy)) {
+        Table<GlobalSchema...> partitioned_table{RowSet<GlobalSchema...>(resource), table.attributes};
+        for (const auto& run : runs) {
+            for (const HashableRow<GlobalSchema...>* row : run.rows) {
+                partitioned_table.data.insert(*row);
             }
         }
-        if (partitioned_table1.data.size() > 0) {
-            partitioned_tables.push_back(partitioned_table1);
-        }
-        if (partitioned_table2.data.size() > 0) {
-            partitioned_tables.push_back(partitioned_table2);
-        }
+        partitioned_tables.push_back(std::move(partitioned_table));
     }
     return partitioned_tables;
 }
 
-// in-place union
+template<typename TableRows, typename... GlobalSchema>
+std::vector<Table<GlobalSchema...>> partition(
+        const BasicTable<TableRows, GlobalSchema...>& table,
+        const attr_type<GlobalSchema...>& partition_attrs,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    return partition(table, partition_attrs, PartitionStrategy(), resource);
+}
+
+// projection X, dictionary Y|XZ and its degree for one partition
 template<typename... GlobalSchema>
-void inplace_union(
-    Table<GlobalSchema...>& inplace_table,
-    Table<GlobalSchema...>& added_table) {
-    for (const auto& row : added_table.data) {
-        inplace_table.data.insert(row);
+struct IndexedPartition {
+    Table<GlobalSchema...> table_X;
+    Dictionary<GlobalSchema...> dict_Y_XZ;
+    std::size_t degree;
+};
+
+// fused projection, construction, extension and degree over the runs of one partition - each X value is
+// projected and hashed once, and each row is only masked to Y
+// - table_X is allocated from table_resource when given (resource otherwise)
+template<typename... GlobalSchema>
+IndexedPartition<GlobalSchema...> index_partition(
+        const std::vector<PartitionRun<GlobalSchema...>>& runs,
+        const attr_type<GlobalSchema...>& attrs_X,
+        const attr_type<GlobalSchema...>& attrs_Y,
+        const attr_type<GlobalSchema...>& attrs_Z,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        std::pmr::memory_resource* table_resource = nullptr) {
+    Table<GlobalSchema...> table_X{RowSet<GlobalSchema...>(table_resource ? table_resource : resource), attrs_X};
+    CsrMap<GlobalSchema...> construction_map(resource);
+    std::size_t row_count = 0;
+    for (const auto& run : runs) {
+        row_count += run.rows.size();
     }
+    table_X.data.reserve(runs.size());
+    construction_map.reserve(runs.size(), row_count);
+    RowSet<GlobalSchema...> seen_Y;
+    for (const auto& run : runs) {
+        table_X.data.insert(mask_row<GlobalSchema...>(attrs_X, *run.rows.front()));
+        // rows over exactly XY are distinct pairs, otherwise Y rows are deduplicated per key
+        bool distinct_pairs = run.rows.front()->attributes == (attrs_X ^ attrs_Y);
+        seen_Y.clear();
+        construction_map.open_group();
+        for (const HashableRow<GlobalSchema...>* row : run.rows) {
+            HashableRow<GlobalSchema...> row_Y = mask_row<GlobalSchema...>(attrs_Y, *row);
+            if (distinct_pairs || seen_Y.insert(row_Y).second) {
+                construction_map.push_row(std::move(row_Y));
+            }
+        }
+        construction_map.close_group(run.key_X);
+    }
+    std::size_t degree = construction_map.degree();
+    return IndexedPartition<GlobalSchema...>{std::move(table_X),
+        ExtendedDictionary<GlobalSchema...>{std::move(construction_map), attrs_X, attrs_Y, attrs_Z}, degree};
+}
+
+// in-place union
+template<typename TableRows, typename AddedRows, typename... GlobalSchema>
+void inplace_union(
+    BasicTable<TableRows, GlobalSchema...>& inplace_table,
+    const BasicTable<AddedRows, GlobalSchema...>& added_table) {
+    inplace_table.data.reserve(inplace_table.data.size() + added_table.data.size());
+    batched_insert(inplace_table.data, added_table.data.begin(), added_table.data.end(),
+        [](const HashableRow<GlobalSchema...>& row) { return row; });
 }
 
 
-// dict degree
+// dict degree (precomputed when the dictionary is built)
 template<typename... GlobalSchema>
-std::size_t degree(const BaseDictionary<GlobalSchema...> dict) {
-    std::size_t degree = 0;
-    for (const auto& [_, rows_Y] : dict.construction_map) {
-        degree = std::max(degree, rows_Y.size());
-    }
-    return degree;
+std::size_t degree(const BaseDictionary<GlobalSchema...>& dict) {
+    return dict.construction_map.degree();
 }
 
 template<typename... GlobalSchema>
-std::size_t degree(const ExtendedDictionary<GlobalSchema...> dict) {
-    std::size_t degree = 0;
-    for (const auto& [_, rows_Y] : dict.construction_map) {
-        degree = std::max(degree, rows_Y.size());
-    }
-    return degree;
+std::size_t degree(const ExtendedDictionary<GlobalSchema...>& dict) {
+    return dict.construction_map.degree();
 }
 
 template<typename... GlobalSchema>
@@ -266,9 +563,68 @@ std::size_t degree(const Dictionary<GlobalSchema...>& dict) {
 }
 
 
-// print
+// content hash - order independent, so equal contents hash equally whatever the insertion order
+template<typename RowRange>
+std::size_t content_hash_rows(const RowRange& rows) {
+    std::size_t sum = 0;
+    for (const auto& row : rows) {
+        sum += row.hash * 0x9e3779b97f4a7c15ULL + (row.hash >> 29);
+    }
+    return sum ^ rows.size();
+}
+
 template<typename... GlobalSchema>
-void print(const Table<GlobalSchema...>& table) {
+std::size_t content_hash(const RowSet<GlobalSchema...>& rows) {
+    return content_hash_rows(rows);
+}
+
+template<typename TableRows, typename... GlobalSchema>
+std::size_t content_hash(const BasicTable<TableRows, GlobalSchema...>& table) {
+    return content_hash_rows(table.data) ^ std::hash<attr_type<GlobalSchema...>>{}(table.attributes);
+}
+
+template<typename... GlobalSchema>
+std::size_t content_hash(const Dictionary<GlobalSchema...>& dict) {
+    const auto visitor = [](const auto& typed_dict) {
+        std::hash<attr_type<GlobalSchema...>> attr_hasher;
+        std::size_t sum = attr_hasher(typed_dict.attributes_X) * 31 + attr_hasher(typed_dict.attributes_Y);
+        for (const auto& [key, rows_Y] : typed_dict.construction_map) {
+            std::size_t seed = std::hash<key_type<GlobalSchema...>>{}(key);
+            sum += seed ^ (content_hash_rows(rows_Y) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+        }
+        return sum;
+    };
+    return std::visit(visitor, dict) + dict.index();
+}
+
+// content equality
+template<typename... GlobalSchema>
+bool same_content(const Table<GlobalSchema...>& table_1, const Table<GlobalSchema...>& table_2) {
+    return table_1.attributes == table_2.attributes && table_1.data == table_2.data;
+}
+
+template<typename... GlobalSchema>
+bool same_content(const Dictionary<GlobalSchema...>& dict_1, const Dictionary<GlobalSchema...>& dict_2) {
+    if (dict_1.index() != dict_2.index()) {
+        return false;
+    }
+    if (const auto* extended = std::get_if<ExtendedDictionary<GlobalSchema...>>(&dict_1)) {
+        if (extended->attributes_Z != std::get<ExtendedDictionary<GlobalSchema...>>(dict_2).attributes_Z) {
+            return false;
+        }
+    }
+    const auto visitor = [&](const auto& typed_dict) {
+        const auto& other = std::get<std::decay_t<decltype(typed_dict)>>(dict_2);
+        return typed_dict.attributes_X == other.attributes_X
+            && typed_dict.attributes_Y == other.attributes_Y
+            && typed_dict.construction_map == other.construction_map;
+    };
+    return std::visit(visitor, dict_1);
+}
+
+// print
+template<typename TableRows, typename... GlobalSchema>
+void print(const BasicTable<TableRows, GlobalSchema...>& table) {
     std::cout << table.attributes << std::endl;
     for (const HashableRow<GlobalSchema...>& row : table.data) {
         print(row);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// witness term counts (D, M or S) with secondary indexes for the case lookups
+// - by_X: terms whose attrs_X equals the key (by_X(NULL_ATTR) lists the unconditional monotonicities)
+// - by_XY: terms whose attrs_X ^ attrs_Y equals the key
+// the indexes list each term with a non-zero count once and are kept in sync by increment/decrement
+template<typename K>
+class WitnessMap {
+public:
+    using map_type = std::unordered_map<K, unsigned>;
+    using attrs_type = decltype(K::attrs_X);
+    using const_iterator = typename map_type::const_iterator;
+
+    WitnessMap() = default;
+
+    WitnessMap(map_type counts_) : counts(std::move(counts_)) {
+        for (const auto& [key, count] : counts) {
+            index(key);
+        }
+    }
+
+    WitnessMap(std::initializer_list<typename map_type::value_type> counts_) : WitnessMap(map_type(counts_)) {}
+
+    const_iterator begin() const {
+        return counts.begin();
+    }
+
+    const_iterator end() const {
+        return counts.end();
+    }
+
+    std::size_t size() const {
+        return counts.size();
+    }
+
+    bool empty() const {
+        return counts.empty();
+    }
+
+    std::size_t count(const K& key) const {
+        return counts.count(key);
+    }
+
+    unsigned at(const K& key) const {
+        return counts.at(key);
+    }
+
+    bool operator==(const WitnessMap& other) const {
+        return counts == other.counts;
+    }
+
+    void increment(const K& key) {
+        if (counts[key]++ == 0) {
+            index(key);
+        }
+    }
+
+    // decrementing a term that is not present is a no-op
+    void decrement(const K& key) {
+        auto it = counts.find(key);
+        if (it == counts.end()) {
+            return;
+        }
+        if (--it->second == 0) {
+            counts.erase(it);
+            unindex(key);
+        }
+    }
+
+    const std::vector<K>& by_X(const attrs_type& attrs) const {
+        return lookup(X_index, attrs);
+    }
+
+    const std::vector<K>& by_XY(const attrs_type& attrs) const {
+        return lookup(XY_index, attrs);
+    }
+
+private:
+    map_type counts;
+    std::unordered_map<attrs_type, std::vector<K>> X_index;
+    std::unordered_map<attrs_type, std::vector<K>> XY_index;
+
+    static const std::vector<K>& lookup(const std::unordered_map<attrs_type, std::vector<K>>& index, const attrs_type& attrs) {
+        static const std::vector<K> EMPTY;
+        auto it = index.find(attrs);
+        return it == index.end() ? EMPTY : it->second;
+    }
+
+    static void remove(std::unordered_map<attrs_type, std::vector<K>>& index, const attrs_type& attrs, const K& key) {
+        auto it = index.find(attrs);
+        std::vector<K>& keys = it->second;
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key) {
+                keys.erase(keys.begin() + i);
+                break;
+            }
+        }
+        if (keys.empty()) {
+            index.erase(it);
+        }
+    }
+
+    void index(const K& key) {
+        X_index[key.attrs_X].push_back(key);
+        XY_index[key.attrs_X ^ key.attrs_Y].push_back(key);
+    }
+
+    void unindex(const K& key) {
+        remove(X_index, key.attrs_X, key);
+        remove(XY_index, key.attrs_X ^ key.attrs_Y, key);
+    }
+};
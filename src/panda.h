@@ -1,45 +1,315 @@
+#include <algorithm>
 #include <array>
 #include <bitset>
 #include <unordered_map>
 #include <unordered_set>
-#include <any>
 #include <functional>
 #include <memory>
 #include <deque>
+#include <iterator>
+#include <mutex>
 
 #include "src/panda_cases.h"
+#include "src/panda_cost.h"
 #include "src/panda_utils.h"
+#include "src/panda_memo.h"
+#include "src/panda_plan.h"
+#include "src/thread_pool.h"
 #include "src/model/panda.h"
+#include "src/model/parallel_table.h"
+#include "src/model/sharded_row_set.h"
 #include "src/model/table.h"
 #include "src/model/row.h"
 
+// order in which the subproblem tree is expanded on a single thread
+// - BREADTH_FIRST collects every leaf subproblem before any output is produced
+// - DEPTH_FIRST handles each leaf as soon as it is reached and drops it, so only the subproblems along
+//   the current path (and their pending siblings) are alive at once
+enum class ExpansionOrder {
+    BREADTH_FIRST,
+    DEPTH_FIRST,
+};
+
+// how the case applied to each subproblem is selected
+// - FIRST_MATCH takes the first unconditional monotonicity in D that matches a case (the order compiled plans use)
+// - CHEAPEST takes the applicable case with the lowest estimated cost (see panda_cost.h), ties broken by a
+//   fixed order on the terms - each monotonicity still takes the case FIRST_MATCH would apply to it
+// - BEAM expands the beam_width cheapest cases and keeps the one whose children are cheapest to expand next -
+//   the expansions are the real data steps (joins, projections, partitions), so the discarded cases cost up to
+//   beam_width - 1 extra data steps at every subproblem
+enum class CaseSelection {
+    FIRST_MATCH,
+    CHEAPEST,
+    BEAM,
+};
+
+// algorithm configuration
+struct PandaOptions {
+    // number of threads expanding the subproblem tree (1 expands it on the calling thread)
+    std::size_t num_threads = 1;
+    ExpansionOrder order = ExpansionOrder::BREADTH_FIRST;
+    // streaming only - emit each output row at most once (tracks every emitted row)
+    bool deduplicate = false;
+    // reuse the leaf outputs of equivalent subproblems (single threaded only, depth first; keeps the tables of
+    // every expanded subproblem alive until the expansion finishes)
+    bool memoize = false;
+    CaseSelection selection = CaseSelection::CHEAPEST;
+    // BEAM only - number of cases expanded at each subproblem (each one runs its data step, kept or not)
+    std::size_t beam_width = 2;
+    // how partition steps group the rows of XY into child subproblems
+    PartitionStrategy partition_strategy;
+};
+
+// union of the leaf tables of each output monotonicity (sharded when the expansion ran on several threads)
+template<typename... GlobalSchema>
+using FeasibleOutput = std::unordered_map<Monotonicity<GlobalSchema...>, ShardedTable<GlobalSchema...>>;
+
+// receives the output attributes and output table of each leaf as the leaf completes
+// - calls are serialized, but come from the pool threads when num_threads > 1
+// - the table is only valid for the duration of the call
+template<typename... GlobalSchema>
+using FeasibleOutputSink = std::function<void(const OutputAttributes<GlobalSchema...>&, const Table<GlobalSchema...>&)>;
+
+// children of subproblem in the tree of original_subproblem (whose Z decides which subproblems are leaves)
+// - the case step runs the parallel operators on pool when given (from outside the pool's tasks only)
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_subproblem_subnodes(const Subproblem<GlobalSchema...>& original_subproblem,
+    const Subproblem<GlobalSchema...>& subproblem,
+    const PandaOptions& options = PandaOptions(),
+    WorkStealingPool* pool = nullptr);
+
+// children of the root subproblem
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_subproblem_subnodes(const Subproblem<GlobalSchema...>& subproblem,
+    const PandaOptions& options = PandaOptions());
+
 template<typename... GlobalSchema>
-std::vector<Subproblem<GlobalSchema...>> generate_subproblem_subnodes(const Subproblem<GlobalSchema...>& subproblem);
+std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> generate_subproblem_leaves(const Subproblem<GlobalSchema...> subproblem,
+    const PandaOptions& options = PandaOptions());
 
 template<typename... GlobalSchema>
-std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> generate_subproblem_leaves(const Subproblem<GlobalSchema...> subproblem);
+std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> generate_subproblem_leaves(const Subproblem<GlobalSchema...> subproblem,
+    WorkStealingPool& pool,
+    const PandaOptions& options = PandaOptions());
+
+template<typename... GlobalSchema, typename LeafHandler>
+void visit_subproblem_leaves_depth_first(const Subproblem<GlobalSchema...>& subproblem, LeafHandler&& on_leaf,
+    const PandaOptions& options = PandaOptions());
+
+template<typename... GlobalSchema, typename LeafHandler>
+void visit_subproblem_leaves(const Subproblem<GlobalSchema...>& subproblem, WorkStealingPool& pool, LeafHandler&& on_leaf,
+    const PandaOptions& options = PandaOptions());
+
+template<typename... GlobalSchema, typename OutputHandler>
+typename SubproblemMemo<GlobalSchema...>::Ranges visit_subproblem_outputs_memoized(const Subproblem<GlobalSchema...>& original_subproblem,
+    Subproblem<GlobalSchema...> subproblem,
+    SubproblemMemo<GlobalSchema...>& memo,
+    OutputHandler& on_output,
+    const PandaOptions& options = PandaOptions(),
+    bool could_repeat = false,
+    bool memoized_ancestor = false);
 
 // function definitions
 
+// on_table(monotonicity, table) with the handle of the output table of every leaf, expanding the tree as
+// options select - calls come from the pool threads when pool is given
+// - the handle is moved out of the leaf, so it is the last one unless the table is shared (e.g. by the memo)
+template<typename... GlobalSchema, typename TableHandler>
+void visit_leaf_tables(const Subproblem<GlobalSchema...>& subproblem,
+    WorkStealingPool* pool,
+    TableHandler&& on_table,
+    const PandaOptions& options) {
+    auto take = [&](Subproblem<GlobalSchema...>& leaf, const Monotonicity<GlobalSchema...>& monotonicity) {
+        on_table(monotonicity, std::move(leaf.Tn_tables.at(monotonicity).at(0).first));
+    };
+
+    if (pool) {
+        visit_subproblem_leaves(subproblem, *pool, [&](Subproblem<GlobalSchema...> leaf, const Monotonicity<GlobalSchema...>& monotonicity, std::size_t) {
+            take(leaf, monotonicity);
+        }, options);
+    } else if (options.memoize) {
+        SubproblemMemo<GlobalSchema...> memo;
+        visit_subproblem_outputs_memoized(subproblem, subproblem, memo, on_table, options);
+    } else if (options.order == ExpansionOrder::DEPTH_FIRST) {
+        visit_subproblem_leaves_depth_first(subproblem, take, options);
+    } else {
+        for (auto& [leaf, monotonicity] : generate_subproblem_leaves(subproblem, options)) {
+            take(leaf, monotonicity);
+        }
+    }
+}
+
+// sink is any callable with the FeasibleOutputSink signature
+template<typename... GlobalSchema, typename Sink>
+void stream_ddr_feasible_output(const Subproblem<GlobalSchema...>& subproblem,
+    Sink&& sink,
+    const PandaOptions& options = PandaOptions()) {
+    std::mutex sink_mutex;
+    std::unordered_map<OutputAttributes<GlobalSchema...>, RowSet<GlobalSchema...>> emitted;
+    auto emit_output = [&](const Monotonicity<GlobalSchema...>& monotonicity, const Shared<Table<GlobalSchema...>>& sub_table) {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        if (!options.deduplicate) {
+            sink(monotonicity.attrs_Y, *sub_table);
+            return;
+        }
+        RowSet<GlobalSchema...>& emitted_rows = emitted[monotonicity.attrs_Y];
+        Table<GlobalSchema...> batch{{}, sub_table->attributes};
+        for (const auto& row : sub_table->data) {
+            if (emitted_rows.insert(row).second) {
+                batch.data.insert(row);
+            }
+        }
+        if (!batch.data.empty()) {
+            sink(monotonicity.attrs_Y, batch);
+        }
+    };
+
+    std::unique_ptr<WorkStealingPool> pool;
+    if (options.num_threads > 1) {
+        pool = std::make_unique<WorkStealingPool>(options.num_threads);
+    }
+    visit_leaf_tables(subproblem, pool.get(), emit_output, options);
+}
+
+// union of the output tables of the leaves of one monotonicity, built as the leaves arrive - each leaf table is
+// merged in and its handle dropped, so a leaf's memory is released as soon as it is merged
+// - the rows are sharded by their cached hash (see ShardedRowSet) and each shard has its own lock, so leaves
+//   that arrive on different pool threads are merged concurrently - the union is the output, so a
+//   ConcurrentRowSet (one heap node per row, scanned by slot) would have to be copied into a table again
+// - with a single shard, a leaf table nothing else references (see table_resource) is moved in whole instead of
+//   copied, when it is larger than the union so far
 template<typename... GlobalSchema>
-std::unordered_map<Monotonicity<GlobalSchema...>, Table<GlobalSchema...>> generate_ddr_feasible_output(const Subproblem<GlobalSchema...> subproblem) {
-    std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> leaves = generate_subproblem_leaves(subproblem);
-    std::unordered_map<Monotonicity<GlobalSchema...>, Table<GlobalSchema...>> feasible_output;
-    for (const auto& leaf : leaves) {
-        Subproblem<GlobalSchema...> subproblem = leaf.first;
-        Monotonicity<GlobalSchema...> monotonicity = leaf.second;
-        Table<GlobalSchema...> sub_table = subproblem.Tn_tables.at(monotonicity).at(0).first;
-        if (feasible_output.count(monotonicity) == 0) {
-            feasible_output[monotonicity] = sub_table;
+class OutputUnion {
+public:
+    OutputUnion(const attr_type<GlobalSchema...>& attributes, unsigned shard_bits)
+        : table{ShardedRowSet<GlobalSchema...>(shard_bits), attributes}, shard_locks(table.data.shard_count()) {}
+
+    // thread safe
+    void add(Shared<Table<GlobalSchema...>> leaf_table) {
+        using Row = HashableRow<GlobalSchema...>;
+        if (table.data.shard_count() == 1) {
+            std::lock_guard<std::mutex> lock(shard_locks[0]);
+            RowSet<GlobalSchema...>& rows = table.data.shard(0);
+            std::optional<Table<GlobalSchema...>> released;
+            if (leaf_table->data.size() > rows.size() && (released = leaf_table.release())) {
+                std::swap(rows, released->data);
+                batched_insert(rows, released->data.begin(), released->data.end(), [](const Row& row) { return row; });
+            } else {
+                rows.reserve(rows.size() + leaf_table->data.size());
+                batched_insert(rows, leaf_table->data.begin(), leaf_table->data.end(), [](const Row& row) { return row; });
+            }
+            return;
+        }
+
+        std::vector<std::vector<const Row*>> shard_rows(table.data.shard_count());
+        for (const Row& row : leaf_table->data) {
+            shard_rows[table.data.shard_of(row.hash)].push_back(&row);
+        }
+        for (std::size_t shard = 0; shard < shard_rows.size(); shard++) {
+            std::lock_guard<std::mutex> lock(shard_locks[shard]);
+            RowSet<GlobalSchema...>& rows = table.data.shard(shard);
+            rows.reserve(rows.size() + shard_rows[shard].size());
+            batched_insert(rows, shard_rows[shard].begin(), shard_rows[shard].end(), [](const Row* row) { return *row; });
+        }
+    }
+
+    // once every leaf is added
+    ShardedTable<GlobalSchema...> take() {
+        return std::move(table);
+    }
+
+private:
+    ShardedTable<GlobalSchema...> table;
+    std::vector<std::mutex> shard_locks;
+};
+
+// union of the leaf tables of every output monotonicity, added from any thread
+template<typename... GlobalSchema>
+class OutputUnions {
+public:
+    explicit OutputUnions(unsigned shard_bits_) : shard_bits(shard_bits_) {}
+
+    void add(const Monotonicity<GlobalSchema...>& monotonicity, Shared<Table<GlobalSchema...>> leaf_table) {
+        OutputUnion<GlobalSchema...>* output_union;
+        {
+            std::lock_guard<std::mutex> lock(unions_mutex);
+            auto& entry = unions[monotonicity];
+            if (!entry) {
+                entry = std::make_unique<OutputUnion<GlobalSchema...>>(leaf_table->attributes, shard_bits);
+            }
+            output_union = entry.get();
+        }
+        output_union->add(std::move(leaf_table));
+    }
+
+    FeasibleOutput<GlobalSchema...> take() {
+        FeasibleOutput<GlobalSchema...> feasible_output;
+        for (auto& [monotonicity, output_union] : unions) {
+            feasible_output.emplace(monotonicity, output_union->take());
+        }
+        return feasible_output;
+    }
+
+private:
+    unsigned shard_bits;
+    std::mutex unions_mutex;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::unique_ptr<OutputUnion<GlobalSchema...>>> unions;
+};
+
+// the leaf tables are merged into their monotonicity's union as they arrive (see OutputUnion) - with several
+// threads the union is sharded so the leaves merge concurrently, and the shards are the output
+template<typename... GlobalSchema>
+FeasibleOutput<GlobalSchema...> generate_ddr_feasible_output(const Subproblem<GlobalSchema...> subproblem,
+    const PandaOptions& options = PandaOptions()) {
+    std::unique_ptr<WorkStealingPool> pool;
+    if (options.num_threads > 1) {
+        pool = std::make_unique<WorkStealingPool>(options.num_threads);
+    }
+    OutputUnions<GlobalSchema...> output_unions(pool ? shard_bits(*pool) : 0);
+    visit_leaf_tables(subproblem, pool.get(),
+        [&](const Monotonicity<GlobalSchema...>& monotonicity, Shared<Table<GlobalSchema...>> sub_table) {
+            output_unions.add(Monotonicity<GlobalSchema...>{monotonicity.attrs_Y, NULL_ATTR<GlobalSchema...>}, std::move(sub_table));
+        },
+        options);
+    return output_unions.take();
+}
+
+// runs a compiled plan instead of selecting cases at every subproblem (with the parallel operators when pool
+// is given, see execute_plan)
+template<typename... GlobalSchema>
+FeasibleOutput<GlobalSchema...> generate_ddr_feasible_output(const Plan<GlobalSchema...>& plan,
+    const Subproblem<GlobalSchema...>& subproblem,
+    const PartitionStrategy& strategy = PartitionStrategy(),
+    WorkStealingPool* pool = nullptr) {
+    OutputUnions<GlobalSchema...> output_unions(0);
+    execute_plan(plan, subproblem, [&](const Subproblem<GlobalSchema...>& leaf, const Monotonicity<GlobalSchema...>& monotonicity) {
+        output_unions.add(monotonicity, leaf.Tn_tables.at(monotonicity).at(0).first);
+    }, strategy, pool);
+    return output_unions.take();
+}
+
+template<typename... GlobalSchema, typename LeafHandler>
+void visit_subproblem_leaves_depth_first(const Subproblem<GlobalSchema...>& subproblem, LeafHandler&& on_leaf,
+    const PandaOptions& options) {
+    std::vector<Subproblem<GlobalSchema...>> curr_problems;
+    curr_problems.push_back(subproblem);
+    while (!curr_problems.empty()) {
+        Subproblem<GlobalSchema...> curr_problem = std::move(curr_problems.back());
+        curr_problems.pop_back();
+        std::optional<Monotonicity<GlobalSchema...>> leaf = is_leaf(subproblem, curr_problem);
+        if (leaf) {
+            on_leaf(curr_problem, *leaf);
         } else {
-            inplace_union(feasible_output[monotonicity], sub_table);
+            // children are pushed in reverse so they are expanded in the order they were generated
+            std::vector<Subproblem<GlobalSchema...>> child_subproblems = generate_subproblem_subnodes(subproblem, curr_problem, options);
+            std::move(child_subproblems.rbegin(), child_subproblems.rend(), std::back_inserter(curr_problems));
         }
     }
-    return feasible_output;
 }
 
 template<typename... GlobalSchema>
-std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> generate_subproblem_leaves(const Subproblem<GlobalSchema...> subproblem) {
+std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> generate_subproblem_leaves(const Subproblem<GlobalSchema...> subproblem,
+    const PandaOptions& options) {
     std::deque<Subproblem<GlobalSchema...>> curr_problems;
     curr_problems.push_back(subproblem);
     std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> leaves;
@@ -53,7 +323,7 @@ std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>
             if (leaf) {
                 leaves.push_back(std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>(curr_problem, *leaf));
             } else {
-                std::vector<Subproblem<GlobalSchema...>> child_subproblems = generate_subproblem_subnodes(curr_problem);
+                std::vector<Subproblem<GlobalSchema...>> child_subproblems = generate_subproblem_subnodes(subproblem, curr_problem, options);
                 curr_problems.insert(curr_problems.end(), std::begin(child_subproblems), std::end(child_subproblems));
             }
         }
@@ -62,37 +332,128 @@ std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>
     return leaves;
 }
 
-template<typename... GlobalSchema>
-std::vector<Subproblem<GlobalSchema...>> generate_subproblem_subnodes(const Subproblem<GlobalSchema...>& subproblem) {
-    std::vector<Subproblem<GlobalSchema...>> subnodes;
-    std::vector<Monotonicity<GlobalSchema...>> unconditional_monotonicities;
-    for (const auto& [monotonicity, count] : subproblem.D) {
-        if (is_unconditional_monotonicity(monotonicity)) {
-            unconditional_monotonicities.push_back(monotonicity);
-        }
+// parallel expansion - each subproblem is a pool task and its children are pushed onto the expanding
+// worker's deque, on_leaf(leaf, monotonicity, worker) is called concurrently from the workers
+// - the root's case step runs on the calling thread with the parallel operators (it holds the largest tables
+//   and has no sibling tasks to overlap with), the rest of the tree runs the sequential operators in the tasks
+template<typename... GlobalSchema, typename LeafHandler>
+void visit_subproblem_leaves(const Subproblem<GlobalSchema...>& subproblem, WorkStealingPool& pool, LeafHandler&& on_leaf,
+    const PandaOptions& options) {
+    std::optional<Monotonicity<GlobalSchema...>> root_leaf = is_leaf(subproblem, subproblem);
+    if (root_leaf) {
+        on_leaf(subproblem, *root_leaf, 0);
+        return;
     }
-    if (unconditional_monotonicities.size() == 0) {
-        throw std::runtime_error("No unconditional monotonicity found");
+
+    std::function<void(Subproblem<GlobalSchema...>, std::size_t)> expand =
+        [&](Subproblem<GlobalSchema...> curr_problem, std::size_t worker) {
+            std::optional<Monotonicity<GlobalSchema...>> leaf = is_leaf(subproblem, curr_problem);
+            if (leaf) {
+                on_leaf(std::move(curr_problem), *leaf, worker);
+                return;
+            }
+            std::vector<Subproblem<GlobalSchema...>> child_subproblems = generate_subproblem_subnodes(subproblem, curr_problem, options);
+            for (auto& child_subproblem : child_subproblems) {
+                auto child = std::make_shared<Subproblem<GlobalSchema...>>(std::move(child_subproblem));
+                pool.submit([&expand, child](std::size_t child_worker) { expand(std::move(*child), child_worker); }, worker);
+            }
+        };
+    for (auto& child_subproblem : generate_subproblem_subnodes(subproblem, subproblem, options, &pool)) {
+        auto child = std::make_shared<Subproblem<GlobalSchema...>>(std::move(child_subproblem));
+        pool.submit([&expand, child](std::size_t worker) { expand(std::move(*child), worker); });
     }
+    pool.wait();
+}
 
-    for (const auto& unconditional_monotonicity : unconditional_monotonicities) {
-        std::optional<Monotonicity<GlobalSchema...>> condition_monotonicity = find_condition_monotonicity(subproblem, unconditional_monotonicity);
-        if (condition_monotonicity) {
-            subnodes.push_back(generate_condition_subproblem(subproblem, unconditional_monotonicity, *condition_monotonicity));
-            return subnodes;
+// memoized depth-first expansion - passes the leaf outputs of subproblem's subtree to on_output(monotonicity,
+// table handle), replayed from the memo when an equivalent subproblem was already expanded, and returns their
+// ranges in the memo
+// - only subproblems below a step with several children (could_repeat) can be reached twice, so only those are
+//   memoized - leaves never are (their output is their table)
+// - a leaf output is only stored when a memoized ancestor can replay it (memoized_ancestor), otherwise its
+//   handle is passed on as the last one
+template<typename... GlobalSchema, typename OutputHandler>
+typename SubproblemMemo<GlobalSchema...>::Ranges visit_subproblem_outputs_memoized(const Subproblem<GlobalSchema...>& original_subproblem,
+    Subproblem<GlobalSchema...> subproblem,
+    SubproblemMemo<GlobalSchema...>& memo,
+    OutputHandler& on_output,
+    const PandaOptions& options,
+    bool could_repeat,
+    bool memoized_ancestor) {
+    typename SubproblemMemo<GlobalSchema...>::Ranges ranges;
+    std::optional<Monotonicity<GlobalSchema...>> leaf = is_leaf(original_subproblem, subproblem);
+    if (leaf) {
+        Shared<Table<GlobalSchema...>> table = std::move(subproblem.Tn_tables.at(*leaf).at(0).first);
+        if (memoized_ancestor) {
+            ranges.push_back(memo.add_output(std::make_pair(*leaf, table)));
+            on_output(*leaf, table);
+        } else {
+            on_output(*leaf, std::move(table));
         }
+        return ranges;
+    }
 
-        std::optional<Monotonicity<GlobalSchema...>> split_monotonicity = find_split_monotonicity(subproblem, unconditional_monotonicity);
-        if (split_monotonicity) {
-            subnodes.push_back(generate_split_subproblem(subproblem, unconditional_monotonicity, *split_monotonicity));
-            return subnodes;
+    std::size_t fingerprint = 0;
+    if (could_repeat) {
+        fingerprint = subproblem_fingerprint(subproblem);
+        if (const auto* cached = memo.find(subproblem, fingerprint)) {
+            ranges = *cached;
+            for (const auto& [begin, end] : ranges) {
+                for (std::size_t i = begin; i < end; i++) {
+                    on_output(memo.output(i).first, memo.output(i).second);
+                }
+            }
+            return ranges;
         }
+    }
 
-        std::optional<Submodularity<GlobalSchema...>> partition_submodularity = find_partition_submodularity(subproblem, unconditional_monotonicity);
-        if (partition_submodularity) {
-            return generate_partition_subproblems(subproblem, unconditional_monotonicity, *partition_submodularity);
-        }
+    std::vector<Subproblem<GlobalSchema...>> child_subproblems = generate_subproblem_subnodes(original_subproblem, subproblem, options);
+    bool children_could_repeat = could_repeat || child_subproblems.size() > 1;
+    for (auto& child_subproblem : child_subproblems) {
+        SubproblemMemo<GlobalSchema...>::append_ranges(ranges, visit_subproblem_outputs_memoized(original_subproblem,
+            std::move(child_subproblem), memo, on_output, options, children_could_repeat, could_repeat));
+    }
+    if (could_repeat) {
+        memo.insert(std::move(subproblem), fingerprint, ranges);
     }
+    return ranges;
+}
+
+// leaves are collected per worker and concatenated once the tree is exhausted
+template<typename... GlobalSchema>
+std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> generate_subproblem_leaves(const Subproblem<GlobalSchema...> subproblem,
+    WorkStealingPool& pool,
+    const PandaOptions& options) {
+    std::vector<std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>>> worker_leaves(pool.size());
+    visit_subproblem_leaves(subproblem, pool, [&](Subproblem<GlobalSchema...> leaf, const Monotonicity<GlobalSchema...>& monotonicity, std::size_t worker) {
+        worker_leaves[worker].push_back(std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>(std::move(leaf), monotonicity));
+    }, options);
 
-    throw std::runtime_error("No unconditional monotonicity matched a case");
+    std::vector<std::pair<Subproblem<GlobalSchema...>, Monotonicity<GlobalSchema...>>> leaves;
+    for (auto& partial_leaves : worker_leaves) {
+        std::move(partial_leaves.begin(), partial_leaves.end(), std::back_inserter(leaves));
+    }
+    return leaves;
+}
+
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_subproblem_subnodes(const Subproblem<GlobalSchema...>& original_subproblem,
+    const Subproblem<GlobalSchema...>& subproblem,
+    const PandaOptions& options,
+    WorkStealingPool* pool) {
+    switch (options.selection) {
+        case CaseSelection::FIRST_MATCH:
+            return generate_case_subproblems(subproblem, choose_case(subproblem), options.partition_strategy, pool);
+        case CaseSelection::CHEAPEST:
+            return generate_cheapest_subproblems(original_subproblem, subproblem, 1, options.partition_strategy, pool);
+        case CaseSelection::BEAM:
+            return generate_cheapest_subproblems(original_subproblem, subproblem, options.beam_width, options.partition_strategy, pool);
+    }
+    throw std::runtime_error("Unknown case selection");
+}
+
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_subproblem_subnodes(const Subproblem<GlobalSchema...>& subproblem,
+    const PandaOptions& options) {
+    return generate_subproblem_subnodes(subproblem, subproblem, options);
 }
@@ -1,84 +1,159 @@
+#pragma once
+
 #include "src/panda_utils.h"
+#include "src/thread_pool.h"
 #include "src/model/panda.h"
+#include "src/model/parallel_table.h"
 #include "src/model/table.h"
 #include "src/model/row.h"
 
-// Case 1: condition monotonicity
+// each case is split into a symbolic step (how D, M, S change - shared with the plan compiler) and a data
+// step (how the tables and dictionaries change - shared with the plan executor)
+// - State is Subproblem or SymbolicState
+// - a data step given a pool runs the parallel operators on its large tables, so it must be called from outside
+//   the pool's tasks (see parallel_table.h) - the tables it adds are still single RowSets
+
 template<typename... GlobalSchema>
-std::optional<Monotonicity<GlobalSchema...>> find_condition_monotonicity(const Subproblem<GlobalSchema...>& subproblem,
+std::pair<Shared<Table<GlobalSchema...>>, Constraint> take_back(
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>>& Tn_tables,
     const Monotonicity<GlobalSchema...>& monotonicity) {
-    for (const auto& [condition_monotonicity, count] : subproblem.D) {
-        if (monotonicity.attrs_Y == condition_monotonicity.attrs_X) {
-            return std::optional<Monotonicity<GlobalSchema...>>(condition_monotonicity);
-        }
+    std::pair<Shared<Table<GlobalSchema...>>, Constraint> entry = std::move(Tn_tables[monotonicity].back());
+    Tn_tables[monotonicity].pop_back();
+    return entry;
+}
+
+template<typename... GlobalSchema>
+std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint> take_back(
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>>& Tn_dicts,
+    const Monotonicity<GlobalSchema...>& monotonicity) {
+    std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint> entry = std::move(Tn_dicts[monotonicity].back());
+    Tn_dicts[monotonicity].pop_back();
+    return entry;
+}
+
+// resource for a new table of monotonicity - a table that can be a leaf output (unconditional, over output
+// attributes) is allocated from the heap rather than the arena, so the output union can move it out of its last
+// handle instead of copying it
+template<typename... GlobalSchema>
+std::pmr::memory_resource* table_resource(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    SubproblemArena& arena) {
+    if (is_unconditional_monotonicity(monotonicity) && subproblem.Z.count(monotonicity.attrs_Y) > 0) {
+        return std::pmr::get_default_resource();
+    }
+    return &arena.resource;
+}
+
+// handle to a table allocated from table_resource - only tables in the arena keep it alive
+template<typename... GlobalSchema>
+Shared<Table<GlobalSchema...>> table_handle(Table<GlobalSchema...> table, const std::shared_ptr<SubproblemArena>& arena) {
+    if (table.data.get_allocator().resource() == &arena->resource) {
+        return Shared<Table<GlobalSchema...>>(std::move(table), arena);
+    }
+    return Shared<Table<GlobalSchema...>>(std::move(table));
+}
+
+// Case 1: condition monotonicity
+template<template<typename...> class State, typename... GlobalSchema>
+std::optional<Monotonicity<GlobalSchema...>> find_condition_monotonicity(const State<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity) {
+    const std::vector<Monotonicity<GlobalSchema...>>& condition_monotonicities = subproblem.D.by_X(monotonicity.attrs_Y);
+    if (!condition_monotonicities.empty()) {
+        return std::optional<Monotonicity<GlobalSchema...>>(condition_monotonicities.front());
     }
     return std::nullopt;
 }
 
 template<typename... GlobalSchema>
-Subproblem<GlobalSchema...> generate_condition_subproblem(const Subproblem<GlobalSchema...>& subproblem,
+Monotonicity<GlobalSchema...> condition_output_monotonicity(const Monotonicity<GlobalSchema...>& condition_monotonicity) {
+    return Monotonicity<GlobalSchema...>{
+        condition_monotonicity.attrs_X ^ condition_monotonicity.attrs_Y,
+        NULL_ATTR<GlobalSchema...>,
+    };
+}
+
+// remove W|0, Y|W from D and add YW|0 to D
+template<template<typename...> class State, typename... GlobalSchema>
+SymbolicState<GlobalSchema...> condition_state(const State<GlobalSchema...>& subproblem,
     const Monotonicity<GlobalSchema...>& monotonicity,
     const Monotonicity<GlobalSchema...>& condition_monotonicity) {
+    WitnessMap<Monotonicity<GlobalSchema...>> D_ = subproblem.D;
+    decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, monotonicity);
+    decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, condition_monotonicity);
+    increment_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, condition_output_monotonicity(condition_monotonicity));
+    return SymbolicState<GlobalSchema...>{subproblem.Z, std::move(D_), subproblem.M, subproblem.S};
+}
 
-    // remove W|0 from tables and remove Y|W from dicts 
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> Tn_tables_ = subproblem.Tn_tables;
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Dictionary<GlobalSchema...>, Constraint>>> Tn_dicts_ = subproblem.Tn_dicts;
-    std::pair<Table<GlobalSchema...>, Constraint> Tn_table_W = Tn_tables_[monotonicity].back();
-    std::pair<Dictionary<GlobalSchema...>, Constraint> Tn_dict_Y_W = Tn_dicts_[condition_monotonicity].back();
-    Tn_tables_[monotonicity].pop_back();
-    Tn_dicts_[condition_monotonicity].pop_back();
+// remove W|0 from tables and Y|W from dicts, and add the join YW|0 to tables if it is within bounds
+// - returns whether the join was added (allocated from arena, see table_resource)
+template<typename... GlobalSchema>
+bool condition_terms(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    const Monotonicity<GlobalSchema...>& condition_monotonicity,
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>>& Tn_tables_,
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>>& Tn_dicts_,
+    std::shared_ptr<SubproblemArena>& arena,
+    WorkStealingPool* pool = nullptr) {
+    std::pair<Shared<Table<GlobalSchema...>>, Constraint> Tn_table_W = take_back(Tn_tables_, monotonicity);
+    std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint> Tn_dict_Y_W = take_back(Tn_dicts_, condition_monotonicity);
     Constraint N_W = Tn_table_W.second;
     Constraint N_Y_W = Tn_dict_Y_W.second;
     Constraint N_YW = N_W * N_Y_W;
+    if (N_YW > subproblem.global_bound) {
+        return false;
+    }
+    arena = std::make_shared<SubproblemArena>();
+    Monotonicity<GlobalSchema...> mon_YW = condition_output_monotonicity(condition_monotonicity);
+    std::pmr::memory_resource* resource = table_resource(subproblem, mon_YW, *arena);
+    // the shards of a parallel join are allocated from the heap (the arena is not thread safe)
+    Table<GlobalSchema...> Tn_table_YW = pool && run_parallel(*pool, Tn_table_W.first->data.size())
+        ? merge_shards(parallel_join(*pool, *Tn_table_W.first, *Tn_dict_Y_W.first), resource)
+        : join(*Tn_table_W.first, *Tn_dict_Y_W.first, resource);
+    Tn_tables_[mon_YW].push_back(std::make_pair(table_handle(std::move(Tn_table_YW), arena), N_YW));
+    return true;
+}
 
-    // remove W|0, Y|W from D and add YW|0 to D
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D_ = subproblem.D;
-    Monotonicity<GlobalSchema...> mon_YW = Monotonicity<GlobalSchema...>{
-        condition_monotonicity.attrs_X ^ condition_monotonicity.attrs_Y,
-        NULL_ATTR<GlobalSchema...>,
-    };
-    decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, monotonicity);
-    decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, condition_monotonicity);
-    increment_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, mon_YW);
+template<typename... GlobalSchema>
+Subproblem<GlobalSchema...> generate_condition_subproblem(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    const Monotonicity<GlobalSchema...>& condition_monotonicity,
+    WorkStealingPool* pool = nullptr) {
 
-    if (N_YW <= subproblem.global_bound) {
-        // Case 1.1 - join within bounds
-        // add join YW|0 to tables
-        Table<GlobalSchema...> Tn_table_YW = join(Tn_table_W.first, Tn_dict_Y_W.first);
-        Tn_tables_[mon_YW].push_back(std::make_pair(Tn_table_YW, N_YW));
+    // only the handles are copied
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_ = subproblem.Tn_tables;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts_ = subproblem.Tn_dicts;
+    std::shared_ptr<SubproblemArena> arena;
+    SymbolicState<GlobalSchema...> state_ = condition_state(subproblem, monotonicity, condition_monotonicity);
 
+    if (condition_terms(subproblem, monotonicity, condition_monotonicity, Tn_tables_, Tn_dicts_, arena, pool)) {
+        // Case 1.1 - join within bounds
         return Subproblem(
-            subproblem.Z,
-            D_,
-            Tn_tables_,
-            Tn_dicts_,
-            subproblem.M,
-            subproblem.S,
-            subproblem.global_bound
+            std::move(state_),
+            std::move(Tn_tables_),
+            std::move(Tn_dicts_),
+            subproblem.global_bound,
+            std::move(arena)
         );
     } else {
         // Case 1.2 - join not within bounds
         // apply reset lemma to remove YW|0
         Subproblem<GlobalSchema...> inter_problem = Subproblem(
-            subproblem.Z,
-            D_,
-            Tn_tables_,
-            Tn_dicts_,
-            subproblem.M,
-            subproblem.S,
-            subproblem.global_bound
+            std::move(state_),
+            std::move(Tn_tables_),
+            std::move(Tn_dicts_),
+            subproblem.global_bound,
+            subproblem.arena
         );
-        return apply_reset_lemma(inter_problem, mon_YW);
-    }    
+        return apply_reset_lemma(inter_problem, condition_output_monotonicity(condition_monotonicity));
+    }
 }
 
 // Case 2: split monotonicity
-template<typename... GlobalSchema>
-std::optional<Monotonicity<GlobalSchema...>> find_split_monotonicity(const Subproblem<GlobalSchema...>& subproblem,
+template<template<typename...> class State, typename... GlobalSchema>
+std::optional<Monotonicity<GlobalSchema...>> find_split_monotonicity(const State<GlobalSchema...>& subproblem,
     const Monotonicity<GlobalSchema...>& monotonicity) {
-    for (const auto& [split_monotonicity, count] : subproblem.M) {
-        if (monotonicity.attrs_Y == (split_monotonicity.attrs_Y ^ split_monotonicity.attrs_X)
-            && (split_monotonicity.attrs_Y != NULL_ATTR<GlobalSchema...>)
+    for (const auto& split_monotonicity : subproblem.M.by_XY(monotonicity.attrs_Y)) {
+        if ((split_monotonicity.attrs_Y != NULL_ATTR<GlobalSchema...>)
             && (split_monotonicity.attrs_X != NULL_ATTR<GlobalSchema...>)) {
             return std::optional<Monotonicity<GlobalSchema...>>(split_monotonicity);
         }
@@ -86,52 +161,69 @@ std::optional<Monotonicity<GlobalSchema...>> find_split_monotonicity(const Subpr
     return std::nullopt;
 }
 
-template<typename... GlobalSchema>
-Subproblem<GlobalSchema...> generate_split_subproblem(const Subproblem<GlobalSchema...>& subproblem, 
+// remove Y|X from M, remove XY|0 and add X|0 to D
+template<template<typename...> class State, typename... GlobalSchema>
+SymbolicState<GlobalSchema...> split_state(const State<GlobalSchema...>& subproblem,
     const Monotonicity<GlobalSchema...>& monotonicity,
     const Monotonicity<GlobalSchema...>& split_monotonicity) {
-
-    // remove Y|X from M
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> M_ = subproblem.M;
+    WitnessMap<Monotonicity<GlobalSchema...>> M_ = subproblem.M;
     decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(M_, split_monotonicity);
 
-    // remove XY|0 and add X|0 to D
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D_ = subproblem.D;
+    WitnessMap<Monotonicity<GlobalSchema...>> D_ = subproblem.D;
     Monotonicity<GlobalSchema...> mon_X = Monotonicity<GlobalSchema...>{
         split_monotonicity.attrs_X,
         NULL_ATTR<GlobalSchema...>,
     };
     increment_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, mon_X);
     decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, monotonicity);
+    return SymbolicState<GlobalSchema...>{subproblem.Z, std::move(D_), std::move(M_), subproblem.S};
+}
 
-    // remove XY and add X to tables
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> Tn_tables_ = subproblem.Tn_tables;
-    std::pair<Table<GlobalSchema...>, Constraint> Tn_table_XY = Tn_tables_[monotonicity].back();
-    Tn_tables_[monotonicity].pop_back();
-    Table<GlobalSchema...> Tn_table_X = project(Tn_table_XY.first, split_monotonicity.attrs_X);
-    if (Tn_tables_.count(mon_X) == 0) {
-        Tn_tables_[mon_X] = {};
-    }
-    Tn_tables_[mon_X].push_back(std::make_pair(Tn_table_X, Tn_table_XY.second));
+// remove XY and add X to tables (allocated from arena, see table_resource)
+template<typename... GlobalSchema>
+void split_terms(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    const Monotonicity<GlobalSchema...>& split_monotonicity,
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>>& Tn_tables_,
+    std::shared_ptr<SubproblemArena>& arena,
+    WorkStealingPool* pool = nullptr) {
+    Monotonicity<GlobalSchema...> mon_X = Monotonicity<GlobalSchema...>{
+        split_monotonicity.attrs_X,
+        NULL_ATTR<GlobalSchema...>,
+    };
+    std::pair<Shared<Table<GlobalSchema...>>, Constraint> Tn_table_XY = take_back(Tn_tables_, monotonicity);
+    arena = std::make_shared<SubproblemArena>();
+    std::pmr::memory_resource* resource = table_resource(subproblem, mon_X, *arena);
+    Table<GlobalSchema...> Tn_table_X = pool && run_parallel(*pool, Tn_table_XY.first->data.size())
+        ? merge_shards(parallel_project(*pool, *Tn_table_XY.first, split_monotonicity.attrs_X), resource)
+        : project(*Tn_table_XY.first, split_monotonicity.attrs_X, resource);
+    Tn_tables_[mon_X].push_back(std::make_pair(table_handle(std::move(Tn_table_X), arena), Tn_table_XY.second));
+}
+
+template<typename... GlobalSchema>
+Subproblem<GlobalSchema...> generate_split_subproblem(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    const Monotonicity<GlobalSchema...>& split_monotonicity,
+    WorkStealingPool* pool = nullptr) {
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_ = subproblem.Tn_tables;
+    std::shared_ptr<SubproblemArena> arena;
+    split_terms(subproblem, monotonicity, split_monotonicity, Tn_tables_, arena, pool);
 
     return Subproblem(
-        subproblem.Z,
-        D_,
-        Tn_tables_,
+        split_state(subproblem, monotonicity, split_monotonicity),
+        std::move(Tn_tables_),
         subproblem.Tn_dicts,
-        M_,
-        subproblem.S,
-        subproblem.global_bound
+        subproblem.global_bound,
+        std::move(arena)
     );
 }
 
 // Case 3: partition submodularity
-template<typename... GlobalSchema>
-std::optional<Submodularity<GlobalSchema...>> find_partition_submodularity(const Subproblem<GlobalSchema...>& subproblem,
+template<template<typename...> class State, typename... GlobalSchema>
+std::optional<Submodularity<GlobalSchema...>> find_partition_submodularity(const State<GlobalSchema...>& subproblem,
     const Monotonicity<GlobalSchema...>& monotonicity) {
-    for (const auto& [partition_submodularity, count] : subproblem.S) {
-        if (monotonicity.attrs_Y == (partition_submodularity.attrs_Y ^ partition_submodularity.attrs_X)
-            && (partition_submodularity.attrs_Y != NULL_ATTR<GlobalSchema...>)
+    for (const auto& partition_submodularity : subproblem.S.by_XY(monotonicity.attrs_Y)) {
+        if ((partition_submodularity.attrs_Y != NULL_ATTR<GlobalSchema...>)
             && (partition_submodularity.attrs_X != NULL_ATTR<GlobalSchema...>)) {
             return std::optional<Submodularity<GlobalSchema...>>(partition_submodularity);
         }
@@ -139,13 +231,12 @@ std::optional<Submodularity<GlobalSchema...>> find_partition_submodularity(const
     return std::nullopt;
 }
 
-template<typename... GlobalSchema>
-std::vector<Subproblem<GlobalSchema...>> generate_partition_subproblems(const Subproblem<GlobalSchema...>& subproblem,
+// remove XY|0 and add X|0, Y|XZ to D, and remove Y;Z|X from S (the same for every partition)
+template<template<typename...> class State, typename... GlobalSchema>
+SymbolicState<GlobalSchema...> partition_state(const State<GlobalSchema...>& subproblem,
     const Monotonicity<GlobalSchema...>& monotonicity,
     const Submodularity<GlobalSchema...>& partition_submodularity) {
-
-    // remove XY|0 and add X|0, Y|XZ to D
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D_ = subproblem.D;
+    WitnessMap<Monotonicity<GlobalSchema...>> D_ = subproblem.D;
     Monotonicity<GlobalSchema...> mon_X = Monotonicity<GlobalSchema...>{
         partition_submodularity.attrs_X,
         NULL_ATTR<GlobalSchema...>,
@@ -158,46 +249,182 @@ std::vector<Subproblem<GlobalSchema...>> generate_partition_subproblems(const Su
     increment_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, mon_YXZ);
     decrement_count<Monotonicity<GlobalSchema...>, GlobalSchema...>(D_, monotonicity);
 
-    // remove Y;Z|X from S
-    std::unordered_map<Submodularity<GlobalSchema...>, unsigned> S_ = subproblem.S;
+    WitnessMap<Submodularity<GlobalSchema...>> S_ = subproblem.S;
     decrement_count<Submodularity<GlobalSchema...>, GlobalSchema...>(S_, partition_submodularity);
+    return SymbolicState<GlobalSchema...>{subproblem.Z, std::move(D_), subproblem.M, std::move(S_)};
+}
+
+// tables and dictionaries of one partition subproblem
+template<typename... GlobalSchema>
+struct PartitionTerms {
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables;
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts;
+    std::shared_ptr<SubproblemArena> arena;
+};
 
-    // remove XY and add partitions X_i, YXZ_i to tables
-    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> Tn_tables_ = subproblem.Tn_tables;
-    std::pair<Table<GlobalSchema...>, Constraint> Tn_table_XY = Tn_tables_[monotonicity].back();
-    Tn_tables_[monotonicity].pop_back();
-    std::vector<Table<GlobalSchema...>> Tn_table_XY_partitions = partition(Tn_table_XY.first, partition_submodularity.attrs_X);
+// remove XY and add partitions X_i, YXZ_i to tables
+// - with a pool the rows are grouped shard by shard and each partition is indexed by its own task (into its
+//   own arena)
+template<typename... GlobalSchema>
+std::vector<PartitionTerms<GlobalSchema...>> partition_terms(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    const Submodularity<GlobalSchema...>& partition_submodularity,
+    const PartitionStrategy& strategy = PartitionStrategy(),
+    WorkStealingPool* pool = nullptr) {
+    Monotonicity<GlobalSchema...> mon_X = Monotonicity<GlobalSchema...>{
+        partition_submodularity.attrs_X,
+        NULL_ATTR<GlobalSchema...>,
+    };
+    Monotonicity<GlobalSchema...> mon_YXZ = Monotonicity<GlobalSchema...>{
+        partition_submodularity.attrs_Y,
+        partition_submodularity.attrs_X ^ partition_submodularity.attrs_Z,
+    };
+
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_ = subproblem.Tn_tables;
+    std::pair<Shared<Table<GlobalSchema...>>, Constraint> Tn_table_XY = take_back(Tn_tables_, monotonicity);
+    bool parallel = pool && run_parallel(*pool, Tn_table_XY.first->data.size());
+    std::vector<std::vector<PartitionRun<GlobalSchema...>>> Tn_table_XY_partitions = parallel
+        ? parallel_group_partitions(*pool, *Tn_table_XY.first, partition_submodularity.attrs_X, strategy)
+        : group_partitions(*Tn_table_XY.first, partition_submodularity.attrs_X, strategy);
+    std::vector<PartitionTerms<GlobalSchema...>> partitions;
+    partitions.reserve(Tn_table_XY_partitions.size());
+    for (std::size_t i = 0; i < Tn_table_XY_partitions.size(); i++) {
+        // each partition subproblem allocates its new tables and dictionaries from its own arena
+        partitions.push_back(PartitionTerms<GlobalSchema...>{Tn_tables_, subproblem.Tn_dicts, std::make_shared<SubproblemArena>()});
+    }
+
+    auto index_terms = [&](std::size_t i) {
+        const std::vector<PartitionRun<GlobalSchema...>>& runs_i = Tn_table_XY_partitions[i];
+        PartitionTerms<GlobalSchema...>& terms = partitions[i];
+
+        // X_i and YXZ_i in one pass over the rows of the partition (note XY is already removed here)
+        IndexedPartition<GlobalSchema...> indexed = index_partition(runs_i, partition_submodularity.attrs_X,
+            partition_submodularity.attrs_Y, partition_submodularity.attrs_Z, &terms.arena->resource,
+            table_resource(subproblem, mon_X, *terms.arena));
+        Constraint N_X_i = indexed.table_X.data.size();
+        terms.Tn_tables[mon_X].push_back(std::make_pair(table_handle(std::move(indexed.table_X), terms.arena), N_X_i));
+        Constraint N_Y_XZ_i = indexed.degree;
+        terms.Tn_dicts[mon_YXZ].push_back(std::make_pair(Shared<Dictionary<GlobalSchema...>>(std::move(indexed.dict_Y_XZ), terms.arena), N_Y_XZ_i));
+    };
+    if (parallel) {
+        for_each_shard(*pool, partitions.size(), index_terms);
+    } else {
+        for (std::size_t i = 0; i < partitions.size(); i++) {
+            index_terms(i);
+        }
+    }
+    return partitions;
+}
+
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_partition_subproblems(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    const Submodularity<GlobalSchema...>& partition_submodularity,
+    const PartitionStrategy& strategy = PartitionStrategy(),
+    WorkStealingPool* pool = nullptr) {
+    SymbolicState<GlobalSchema...> state_ = partition_state(subproblem, monotonicity, partition_submodularity);
     std::vector<Subproblem<GlobalSchema...>> partition_subproblems = {};
-    for (const auto& Tn_table_XY_i : Tn_table_XY_partitions) {
-        // add X_i to tables (note XY is already removed here)
-        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Table<GlobalSchema...>, Constraint>>> partition_Tn_tables_ = Tn_tables_;
-        Table<GlobalSchema...> Tn_table_X_i = project(Tn_table_XY_i, partition_submodularity.attrs_X);
-        Constraint N_X_i = Tn_table_X_i.data.size();
-        if (partition_Tn_tables_.count(mon_X) == 0) {
-            partition_Tn_tables_[mon_X] = {};
+    for (auto& terms : partition_terms(subproblem, monotonicity, partition_submodularity, strategy, pool)) {
+        partition_subproblems.push_back(Subproblem(
+            state_,
+            std::move(terms.Tn_tables),
+            std::move(terms.Tn_dicts),
+            subproblem.global_bound,
+            std::move(terms.arena)
+        ));
+    }
+    return partition_subproblems;
+}
+
+// case selection
+enum class CaseType {
+    CONDITION,
+    SPLIT,
+    PARTITION,
+};
+
+template<typename... GlobalSchema>
+struct CaseChoice {
+    CaseType type;
+    Monotonicity<GlobalSchema...> monotonicity;
+    // condition or split monotonicity
+    Monotonicity<GlobalSchema...> witness_monotonicity;
+    Submodularity<GlobalSchema...> witness_submodularity;
+};
+
+// the first unconditional monotonicity in D that matches a case
+template<template<typename...> class State, typename... GlobalSchema>
+CaseChoice<GlobalSchema...> choose_case(const State<GlobalSchema...>& subproblem) {
+    const std::vector<Monotonicity<GlobalSchema...>>& unconditional_monotonicities = subproblem.D.by_X(NULL_ATTR<GlobalSchema...>);
+    if (unconditional_monotonicities.size() == 0) {
+        throw std::runtime_error("No unconditional monotonicity found");
+    }
+
+    for (const auto& unconditional_monotonicity : unconditional_monotonicities) {
+        std::optional<Monotonicity<GlobalSchema...>> condition_monotonicity = find_condition_monotonicity(subproblem, unconditional_monotonicity);
+        if (condition_monotonicity) {
+            return CaseChoice<GlobalSchema...>{CaseType::CONDITION, unconditional_monotonicity, *condition_monotonicity, {}};
         }
-        partition_Tn_tables_[mon_X].push_back(std::make_pair(Tn_table_X_i, N_X_i));
-
-        // add YXZ_i to dicts
-        std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Dictionary<GlobalSchema...>, Constraint>>> partition_Tn_dicts_ = subproblem.Tn_dicts;
-        Dictionary<GlobalSchema...> Tn_dict_Y_X_i = construction(Tn_table_XY_i, partition_submodularity.attrs_X, partition_submodularity.attrs_Y);
-        Dictionary<GlobalSchema...> Tn_dict_Y_XZ_i = extension(Tn_dict_Y_X_i, partition_submodularity.attrs_Z);
-        Constraint N_Y_XZ_i = degree(Tn_dict_Y_XZ_i);
-        if (partition_Tn_dicts_.count(mon_YXZ) == 0) {
-            partition_Tn_dicts_[mon_YXZ] = {};
+
+        std::optional<Monotonicity<GlobalSchema...>> split_monotonicity = find_split_monotonicity(subproblem, unconditional_monotonicity);
+        if (split_monotonicity) {
+            return CaseChoice<GlobalSchema...>{CaseType::SPLIT, unconditional_monotonicity, *split_monotonicity, {}};
+        }
+
+        std::optional<Submodularity<GlobalSchema...>> partition_submodularity = find_partition_submodularity(subproblem, unconditional_monotonicity);
+        if (partition_submodularity) {
+            return CaseChoice<GlobalSchema...>{CaseType::PARTITION, unconditional_monotonicity, {}, *partition_submodularity};
         }
-        partition_Tn_dicts_[mon_YXZ].push_back(std::make_pair(Tn_dict_Y_XZ_i, N_Y_XZ_i));
-
-        Subproblem<GlobalSchema...> partition_subproblem = Subproblem(
-            subproblem.Z,
-            D_,
-            partition_Tn_tables_,
-            partition_Tn_dicts_,
-            subproblem.M,
-            S_,
-            subproblem.global_bound
-        );
-        partition_subproblems.push_back(partition_subproblem);
     }
-    return partition_subproblems;
+
+    throw std::runtime_error("No unconditional monotonicity matched a case");
+}
+
+// every (unconditional monotonicity, case) pair that applies to the subproblem, in choose_case order
+// - each monotonicity only takes the case choose_case would apply to it (condition, then split, then partition),
+//   with any of its witnesses - so a cost-based selection only reorders the monotonicities and witnesses
+template<template<typename...> class State, typename... GlobalSchema>
+std::vector<CaseChoice<GlobalSchema...>> applicable_cases(const State<GlobalSchema...>& subproblem) {
+    std::vector<CaseChoice<GlobalSchema...>> choices;
+    for (const auto& unconditional_monotonicity : subproblem.D.by_X(NULL_ATTR<GlobalSchema...>)) {
+        std::size_t matched = choices.size();
+        for (const auto& condition_monotonicity : subproblem.D.by_X(unconditional_monotonicity.attrs_Y)) {
+            choices.push_back(CaseChoice<GlobalSchema...>{CaseType::CONDITION, unconditional_monotonicity, condition_monotonicity, {}});
+        }
+        if (choices.size() > matched) {
+            continue;
+        }
+        for (const auto& split_monotonicity : subproblem.M.by_XY(unconditional_monotonicity.attrs_Y)) {
+            if ((split_monotonicity.attrs_Y != NULL_ATTR<GlobalSchema...>)
+                && (split_monotonicity.attrs_X != NULL_ATTR<GlobalSchema...>)) {
+                choices.push_back(CaseChoice<GlobalSchema...>{CaseType::SPLIT, unconditional_monotonicity, split_monotonicity, {}});
+            }
+        }
+        if (choices.size() > matched) {
+            continue;
+        }
+        for (const auto& partition_submodularity : subproblem.S.by_XY(unconditional_monotonicity.attrs_Y)) {
+            if ((partition_submodularity.attrs_Y != NULL_ATTR<GlobalSchema...>)
+                && (partition_submodularity.attrs_X != NULL_ATTR<GlobalSchema...>)) {
+                choices.push_back(CaseChoice<GlobalSchema...>{CaseType::PARTITION, unconditional_monotonicity, {}, partition_submodularity});
+            }
+        }
+    }
+    return choices;
+}
+
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_case_subproblems(const Subproblem<GlobalSchema...>& subproblem,
+    const CaseChoice<GlobalSchema...>& choice,
+    const PartitionStrategy& strategy = PartitionStrategy(),
+    WorkStealingPool* pool = nullptr) {
+    switch (choice.type) {
+        case CaseType::CONDITION:
+            return {generate_condition_subproblem(subproblem, choice.monotonicity, choice.witness_monotonicity, pool)};
+        case CaseType::SPLIT:
+            return {generate_split_subproblem(subproblem, choice.monotonicity, choice.witness_monotonicity, pool)};
+        case CaseType::PARTITION:
+            return generate_partition_subproblems(subproblem, choice.monotonicity, choice.witness_submodularity, strategy, pool);
+    }
+    throw std::runtime_error("Unknown case");
 }
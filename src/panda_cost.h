@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "src/panda_cases.h"
+#include "src/model/panda.h"
+#include "src/model/table.h"
+
+// cost model for case selection - estimated rows touched by the data step of a case
+// - CONDITION: the join of W|0 with Y|W (|W| * deg(Y|W)), or nothing when N_W * N_Y_W exceeds the bound and
+//   the reset lemma applies instead
+// - SPLIT: one projection of XY
+// - PARTITION: partitioning, projecting and indexing XY, repeated by each of the ~log |XY| partition subtrees
+
+template<typename T, typename... GlobalSchema>
+const std::pair<Shared<T>, Constraint>* back_term(
+    const std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<T>, Constraint>>>& terms,
+    const Monotonicity<GlobalSchema...>& monotonicity) {
+    auto it = terms.find(monotonicity);
+    if (it == terms.end() || it->second.empty()) {
+        return nullptr;
+    }
+    return &it->second.back();
+}
+
+template<typename... GlobalSchema>
+long double case_cost(const Subproblem<GlobalSchema...>& subproblem, const CaseChoice<GlobalSchema...>& choice) {
+    const auto* Tn_table = back_term(subproblem.Tn_tables, choice.monotonicity);
+    long double size = Tn_table ? Tn_table->first->data.size() : 0;
+    switch (choice.type) {
+        case CaseType::CONDITION: {
+            const auto* Tn_dict = back_term(subproblem.Tn_dicts, choice.witness_monotonicity);
+            if (!Tn_table || !Tn_dict || Tn_table->second * Tn_dict->second > subproblem.global_bound) {
+                return 0;
+            }
+            return size * std::max<long double>(Tn_dict->second, 1);
+        }
+        case CaseType::SPLIT:
+            return size;
+        case CaseType::PARTITION:
+            return size * (std::log2(std::max<long double>(size, 1)) + 2);
+    }
+    return 0;
+}
+
+// whether the data step of a case can complete - only a condition whose join exceeds the bound can fail, when
+// the reset lemma finds no term to remove YW|0 with, and that is decided by the constraints and the symbolic
+// state alone (the same test condition_terms makes), before any table is touched
+template<typename... GlobalSchema>
+bool case_feasible(const Subproblem<GlobalSchema...>& subproblem, const CaseChoice<GlobalSchema...>& choice) {
+    if (choice.type != CaseType::CONDITION) {
+        return true;
+    }
+    const auto* Tn_table = back_term(subproblem.Tn_tables, choice.monotonicity);
+    const auto* Tn_dict = back_term(subproblem.Tn_dicts, choice.witness_monotonicity);
+    if (!Tn_table || !Tn_dict || Tn_table->second * Tn_dict->second <= subproblem.global_bound) {
+        return true;
+    }
+    std::vector<Monotonicity<GlobalSchema...>> dict_pops;
+    return try_symbolic_reset_lemma(condition_state(subproblem, choice.monotonicity, choice.witness_monotonicity),
+        condition_output_monotonicity(choice.witness_monotonicity), dict_pops).has_value();
+}
+
+// total order on choices of equal cost, so the selection does not depend on hash-table iteration order
+template<typename... GlobalSchema>
+bool case_precedes(const CaseChoice<GlobalSchema...>& choice_1, const CaseChoice<GlobalSchema...>& choice_2) {
+    auto key = [](const CaseChoice<GlobalSchema...>& choice) {
+        return std::make_tuple(static_cast<int>(choice.type),
+            choice.monotonicity.to_string(),
+            choice.witness_monotonicity.to_string(),
+            choice.witness_submodularity.to_string());
+    };
+    return key(choice_1) < key(choice_2);
+}
+
+// applicable and feasible cases with their costs, cheapest first
+template<typename... GlobalSchema>
+std::vector<std::pair<CaseChoice<GlobalSchema...>, long double>> rank_cases(const Subproblem<GlobalSchema...>& subproblem) {
+    std::vector<std::pair<CaseChoice<GlobalSchema...>, long double>> ranked;
+    for (const auto& choice : applicable_cases(subproblem)) {
+        if (case_feasible(subproblem, choice)) {
+            ranked.emplace_back(choice, case_cost(subproblem, choice));
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& entry_1, const auto& entry_2) {
+        if (entry_1.second != entry_2.second) {
+            return entry_1.second < entry_2.second;
+        }
+        return case_precedes(entry_1.first, entry_2.first);
+    });
+    return ranked;
+}
+
+// expands the cheapest case, or with beam_width > 1 runs a beam search with one step of lookahead - the
+// beam_width cheapest cases are expanded, each scored by its own cost plus the cheapest case of every child,
+// and the children of the best scoring case are returned
+// - leaf children add nothing to the score (leaves are checked against original_subproblem, see is_leaf)
+// - only feasible cases are ranked (see case_feasible) - with none, the case choose_case picks is expanded so
+//   its error surfaces, and errors of an expansion are never caught
+// - pool is passed to the case steps (see generate_case_subproblems)
+template<typename... GlobalSchema>
+std::vector<Subproblem<GlobalSchema...>> generate_cheapest_subproblems(const Subproblem<GlobalSchema...>& original_subproblem,
+    const Subproblem<GlobalSchema...>& subproblem,
+    std::size_t beam_width = 1,
+    const PartitionStrategy& strategy = PartitionStrategy(),
+    WorkStealingPool* pool = nullptr) {
+    std::vector<std::pair<CaseChoice<GlobalSchema...>, long double>> ranked = rank_cases(subproblem);
+    if (ranked.empty()) {
+        return generate_case_subproblems(subproblem, choose_case(subproblem), strategy, pool);
+    }
+    if (beam_width <= 1) {
+        return generate_case_subproblems(subproblem, ranked.front().first, strategy, pool);
+    }
+
+    std::vector<Subproblem<GlobalSchema...>> best_children;
+    long double best_score = 0;
+    for (std::size_t i = 0; i < std::min(ranked.size(), beam_width); i++) {
+        std::vector<Subproblem<GlobalSchema...>> children = generate_case_subproblems(subproblem, ranked[i].first, strategy, pool);
+        long double score = ranked[i].second;
+        for (const auto& child : children) {
+            if (is_leaf(original_subproblem, child)) {
+                continue;
+            }
+            std::vector<std::pair<CaseChoice<GlobalSchema...>, long double>> child_ranked = rank_cases(child);
+            if (!child_ranked.empty()) {
+                score += child_ranked.front().second;
+            }
+        }
+        // ties keep the cheaper immediate case
+        if (i == 0 || score < best_score) {
+            best_children = std::move(children);
+            best_score = score;
+        }
+    }
+    return best_children;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/model/panda.h"
+#include "src/model/table.h"
+
+// content-addressed memoization - subproblems with the same symbolic state, bound, constraints and table /
+// dictionary contents expand to the same leaves, so their leaf outputs are recorded once and reused
+
+// order independent over monotonicities, ordered within each term list (cases pop from the back)
+template<typename K, typename T>
+std::size_t hash_handle_terms(const std::unordered_map<K, std::vector<std::pair<Shared<T>, Constraint>>>& terms) {
+    std::size_t sum = 0;
+    for (const auto& [key, entries] : terms) {
+        if (entries.empty()) {
+            continue;
+        }
+        std::size_t seed = std::hash<K>{}(key);
+        for (const auto& [handle, constraint] : entries) {
+            seed ^= handle.hash_content() + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<Constraint>{}(constraint) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        sum += seed;
+    }
+    return sum;
+}
+
+// empty term lists are treated as absent
+template<typename K, typename T>
+bool equivalent_handle_terms(const std::unordered_map<K, std::vector<std::pair<Shared<T>, Constraint>>>& terms_1,
+    const std::unordered_map<K, std::vector<std::pair<Shared<T>, Constraint>>>& terms_2) {
+    std::size_t non_empty_1 = 0;
+    for (const auto& [key, entries] : terms_1) {
+        if (entries.empty()) {
+            continue;
+        }
+        non_empty_1++;
+        auto it = terms_2.find(key);
+        if (it == terms_2.end() || it->second.size() != entries.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            const auto& [handle_1, constraint_1] = entries[i];
+            const auto& [handle_2, constraint_2] = it->second[i];
+            if (constraint_1 != constraint_2) {
+                return false;
+            }
+            if (!handle_1.same_object(handle_2)
+                && (handle_1.hash_content() != handle_2.hash_content() || !same_content(*handle_1, *handle_2))) {
+                return false;
+            }
+        }
+    }
+    std::size_t non_empty_2 = 0;
+    for (const auto& [key, entries] : terms_2) {
+        non_empty_2 += !entries.empty();
+    }
+    return non_empty_1 == non_empty_2;
+}
+
+template<typename... GlobalSchema>
+std::size_t subproblem_fingerprint(const Subproblem<GlobalSchema...>& subproblem) {
+    using state_hasher = std::hash<SymbolicState<GlobalSchema...>>;
+    std::size_t seed = 0;
+    seed ^= state_hasher::hash_terms(subproblem.Z) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= state_hasher::hash_terms(subproblem.D) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= state_hasher::hash_terms(subproblem.M) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= state_hasher::hash_terms(subproblem.S) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= hash_handle_terms(subproblem.Tn_tables) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= hash_handle_terms(subproblem.Tn_dicts) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<long double>{}(subproblem.global_bound) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+template<typename... GlobalSchema>
+bool equivalent_subproblems(const Subproblem<GlobalSchema...>& subproblem_1, const Subproblem<GlobalSchema...>& subproblem_2) {
+    return subproblem_1.global_bound == subproblem_2.global_bound
+        && subproblem_1.Z == subproblem_2.Z
+        && subproblem_1.D == subproblem_2.D
+        && subproblem_1.M == subproblem_2.M
+        && subproblem_1.S == subproblem_2.S
+        && equivalent_handle_terms(subproblem_1.Tn_tables, subproblem_2.Tn_tables)
+        && equivalent_handle_terms(subproblem_1.Tn_dicts, subproblem_2.Tn_dicts);
+}
+
+// leaf outputs of expanded subproblems by fingerprint (fingerprint matches are verified exactly)
+// - each leaf output is stored once, in the order the leaves are reached, and an entry lists the ranges of its
+//   subtree's outputs (one range, plus one per subtree it reused) rather than copies of them
+// - entries keep their subproblem's tables and dictionaries alive for the lifetime of the memo
+template<typename... GlobalSchema>
+class SubproblemMemo {
+public:
+    using Output = std::pair<Monotonicity<GlobalSchema...>, Shared<Table<GlobalSchema...>>>;
+    // [begin, end) ranges of outputs
+    using Ranges = std::vector<std::pair<std::size_t, std::size_t>>;
+
+    const Ranges* find(const Subproblem<GlobalSchema...>& subproblem, std::size_t fingerprint) {
+        auto it = entries.find(fingerprint);
+        if (it == entries.end()) {
+            return nullptr;
+        }
+        for (const auto& [expanded, ranges] : it->second) {
+            if (equivalent_subproblems(expanded, subproblem)) {
+                hit_count++;
+                return &ranges;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(Subproblem<GlobalSchema...> subproblem, std::size_t fingerprint, Ranges ranges) {
+        entries[fingerprint].emplace_back(std::move(subproblem), std::move(ranges));
+    }
+
+    // stores a leaf output - returns its range
+    std::pair<std::size_t, std::size_t> add_output(Output output) {
+        outputs.push_back(std::move(output));
+        return std::make_pair(outputs.size() - 1, outputs.size());
+    }
+
+    const Output& output(std::size_t index) const {
+        return outputs[index];
+    }
+
+    // appends more to ranges, merging a range that continues the last one
+    static void append_ranges(Ranges& ranges, const Ranges& more) {
+        for (const auto& range : more) {
+            if (!ranges.empty() && ranges.back().second == range.first) {
+                ranges.back().second = range.second;
+            } else {
+                ranges.push_back(range);
+            }
+        }
+    }
+
+    std::size_t hits() const {
+        return hit_count;
+    }
+
+private:
+    std::vector<Output> outputs;
+    std::unordered_map<std::size_t, std::vector<std::pair<Subproblem<GlobalSchema...>, Ranges>>> entries;
+    std::size_t hit_count = 0;
+};
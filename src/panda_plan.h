@@ -0,0 +1,206 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/panda_cases.h"
+#include "src/panda_utils.h"
+#include "src/model/panda.h"
+#include "src/model/table.h"
+
+// symbolic plan - the proof sequence of a query compiled once from its symbolic state and executed over any
+// tables with the same shape
+// - nodes are shared between every path reaching the same symbolic state, so the plan is a DAG
+// - CONDITION (bound check on N_YW) and PARTITION (fan-out) are the only data-dependent steps
+// - branches where no case applies compile to FAILED nodes, which throw only if the data reaches them
+enum class PlanStep {
+    LEAF,
+    CONDITION,
+    SPLIT,
+    PARTITION,
+    FAILED,
+};
+
+template<typename... GlobalSchema>
+struct PlanNode {
+    PlanStep step;
+    // symbolic state of the subproblems reaching this node
+    SymbolicState<GlobalSchema...> state;
+    // unconditional monotonicity the step is applied to (the output monotonicity for leaves)
+    Monotonicity<GlobalSchema...> monotonicity;
+    // condition or split monotonicity
+    Monotonicity<GlobalSchema...> witness_monotonicity;
+    Submodularity<GlobalSchema...> witness_submodularity;
+
+    // next step (for CONDITION: the join is within bounds, for PARTITION: every partition)
+    std::shared_ptr<const PlanNode> next;
+    // CONDITION only: the join exceeds the bound and the reset lemma removed YW|0 (consuming reset_dict_pops)
+    std::shared_ptr<const PlanNode> over_bound;
+    std::vector<Monotonicity<GlobalSchema...>> reset_dict_pops;
+    // FAILED only
+    std::string error;
+
+    bool data_dependent() const {
+        return step == PlanStep::CONDITION || step == PlanStep::PARTITION;
+    }
+};
+
+template<typename... GlobalSchema>
+struct Plan {
+    std::shared_ptr<const PlanNode<GlobalSchema...>> root;
+    // number of distinct nodes
+    std::size_t size;
+};
+
+template<typename... GlobalSchema>
+std::shared_ptr<const PlanNode<GlobalSchema...>> compile_plan_node(const SymbolicState<GlobalSchema...>& original_state,
+    const SymbolicState<GlobalSchema...>& state,
+    std::unordered_map<SymbolicState<GlobalSchema...>, std::shared_ptr<const PlanNode<GlobalSchema...>>>& compiled) {
+    auto it = compiled.find(state);
+    if (it != compiled.end()) {
+        return it->second;
+    }
+
+    auto node = std::make_shared<PlanNode<GlobalSchema...>>();
+    node->state = state;
+    std::optional<Monotonicity<GlobalSchema...>> leaf = is_leaf(original_state, state);
+    if (leaf) {
+        node->step = PlanStep::LEAF;
+        node->monotonicity = *leaf;
+        compiled.emplace(state, node);
+        return node;
+    }
+
+    std::optional<CaseChoice<GlobalSchema...>> choice;
+    try {
+        choice = choose_case(state);
+    } catch (const std::runtime_error& e) {
+        node->step = PlanStep::FAILED;
+        node->error = e.what();
+    }
+    if (choice) {
+        node->monotonicity = choice->monotonicity;
+        node->witness_monotonicity = choice->witness_monotonicity;
+        node->witness_submodularity = choice->witness_submodularity;
+        switch (choice->type) {
+            case CaseType::CONDITION: {
+                node->step = PlanStep::CONDITION;
+                SymbolicState<GlobalSchema...> joined_state = condition_state(state, choice->monotonicity, choice->witness_monotonicity);
+                node->next = compile_plan_node(original_state, joined_state, compiled);
+                try {
+                    SymbolicState<GlobalSchema...> reset_state = apply_symbolic_reset_lemma(joined_state,
+                        condition_output_monotonicity(choice->witness_monotonicity), node->reset_dict_pops);
+                    node->over_bound = compile_plan_node(original_state, reset_state, compiled);
+                } catch (const std::runtime_error& e) {
+                    auto failed = std::make_shared<PlanNode<GlobalSchema...>>();
+                    failed->step = PlanStep::FAILED;
+                    failed->error = e.what();
+                    node->over_bound = failed;
+                }
+                break;
+            }
+            case CaseType::SPLIT:
+                node->step = PlanStep::SPLIT;
+                node->next = compile_plan_node(original_state, split_state(state, choice->monotonicity, choice->witness_monotonicity), compiled);
+                break;
+            case CaseType::PARTITION:
+                node->step = PlanStep::PARTITION;
+                node->next = compile_plan_node(original_state, partition_state(state, choice->monotonicity, choice->witness_submodularity), compiled);
+                break;
+        }
+    }
+    compiled.emplace(state, node);
+    return node;
+}
+
+template<typename... GlobalSchema>
+Plan<GlobalSchema...> compile_plan(const SymbolicState<GlobalSchema...>& state) {
+    std::unordered_map<SymbolicState<GlobalSchema...>, std::shared_ptr<const PlanNode<GlobalSchema...>>> compiled;
+    std::shared_ptr<const PlanNode<GlobalSchema...>> root = compile_plan_node(state, state, compiled);
+    return Plan<GlobalSchema...>{std::move(root), compiled.size()};
+}
+
+// compiled plans by the symbolic state of the query - safe to share between threads and runs
+template<typename... GlobalSchema>
+class PlanCache {
+public:
+    std::shared_ptr<const Plan<GlobalSchema...>> get(const SymbolicState<GlobalSchema...>& state) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = plans.find(state);
+        if (it == plans.end()) {
+            it = plans.emplace(state, std::make_shared<const Plan<GlobalSchema...>>(compile_plan(state))).first;
+        }
+        return it->second;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return plans.size();
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<SymbolicState<GlobalSchema...>, std::shared_ptr<const Plan<GlobalSchema...>>> plans;
+};
+
+// runs a plan depth first over the tables and dictionaries of subproblem, on_leaf(leaf, monotonicity) is
+// called for each leaf - only the data steps run here, every symbolic decision comes from the plan
+// - the steps run on the calling thread, so each one runs the parallel operators on pool when given
+template<typename... GlobalSchema, typename LeafHandler>
+void execute_plan(const Plan<GlobalSchema...>& plan, const Subproblem<GlobalSchema...>& subproblem, LeafHandler&& on_leaf,
+    const PartitionStrategy& strategy = PartitionStrategy(),
+    WorkStealingPool* pool = nullptr) {
+    if (!(plan.root->state == subproblem.symbolic_state())) {
+        throw std::runtime_error("Plan was compiled for a different symbolic state");
+    }
+
+    std::vector<std::pair<const PlanNode<GlobalSchema...>*, Subproblem<GlobalSchema...>>> curr_problems;
+    curr_problems.emplace_back(plan.root.get(), subproblem);
+    while (!curr_problems.empty()) {
+        const PlanNode<GlobalSchema...>* node = curr_problems.back().first;
+        Subproblem<GlobalSchema...> curr_problem = std::move(curr_problems.back().second);
+        curr_problems.pop_back();
+
+        switch (node->step) {
+            case PlanStep::LEAF:
+                on_leaf(curr_problem, node->monotonicity);
+                break;
+            case PlanStep::CONDITION: {
+                std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_ = curr_problem.Tn_tables;
+                std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts_ = curr_problem.Tn_dicts;
+                std::shared_ptr<SubproblemArena> arena;
+                if (condition_terms(curr_problem, node->monotonicity, node->witness_monotonicity, Tn_tables_, Tn_dicts_, arena, pool)) {
+                    curr_problems.emplace_back(node->next.get(), Subproblem(node->next->state,
+                        std::move(Tn_tables_), std::move(Tn_dicts_), curr_problem.global_bound, std::move(arena)));
+                } else {
+                    curr_problems.emplace_back(node->over_bound.get(), Subproblem(node->over_bound->state,
+                        std::move(Tn_tables_), pop_dicts(std::move(Tn_dicts_), node->reset_dict_pops), curr_problem.global_bound, curr_problem.arena));
+                }
+                break;
+            }
+            case PlanStep::SPLIT: {
+                std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Table<GlobalSchema...>>, Constraint>>> Tn_tables_ = curr_problem.Tn_tables;
+                std::shared_ptr<SubproblemArena> arena;
+                split_terms(curr_problem, node->monotonicity, node->witness_monotonicity, Tn_tables_, arena, pool);
+                curr_problems.emplace_back(node->next.get(), Subproblem(node->next->state,
+                    std::move(Tn_tables_), curr_problem.Tn_dicts, curr_problem.global_bound, std::move(arena)));
+                break;
+            }
+            case PlanStep::PARTITION: {
+                std::vector<PartitionTerms<GlobalSchema...>> partitions = partition_terms(curr_problem, node->monotonicity, node->witness_submodularity, strategy, pool);
+                // pushed in reverse so partitions are expanded in order
+                for (auto it = partitions.rbegin(); it != partitions.rend(); it++) {
+                    curr_problems.emplace_back(node->next.get(), Subproblem(node->next->state,
+                        std::move(it->Tn_tables), std::move(it->Tn_dicts), curr_problem.global_bound, std::move(it->arena)));
+                }
+                break;
+            }
+            case PlanStep::FAILED:
+                throw std::runtime_error(node->error);
+        }
+    }
+}
@@ -1,17 +1,19 @@
 #pragma once
 
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
 #include "src/model/panda.h"
 #include "src/model/table.h"
 #include "src/model/row.h"
 
-template<typename... GlobalSchema>
-std::optional<Monotonicity<GlobalSchema...>> is_leaf(const Subproblem<GlobalSchema...>& original_subproblem, const Subproblem<GlobalSchema...>& subproblem) {
-    bool found_output_monotonicity = false;
-    for (const auto& [monotonicity, count] : subproblem.D) {
-        for (const auto& [output_attributes, count] : original_subproblem.Z) {
-            if (monotonicity.attrs_Y == output_attributes && is_unconditional_monotonicity(monotonicity)) {
-                return std::optional(monotonicity);
-            }
+// State is Subproblem or SymbolicState
+template<template<typename...> class OriginalState, template<typename...> class State, typename... GlobalSchema>
+std::optional<Monotonicity<GlobalSchema...>> is_leaf(const OriginalState<GlobalSchema...>& original_subproblem, const State<GlobalSchema...>& subproblem) {
+    for (const auto& monotonicity : subproblem.D.by_X(NULL_ATTR<GlobalSchema...>)) {
+        if (original_subproblem.Z.count(monotonicity.attrs_Y) > 0) {
+            return std::optional(monotonicity);
         }
     }
     return std::nullopt;
@@ -36,123 +38,139 @@ void increment_count(std::unordered_map<K, unsigned>& map, const K& key) {
     map[key]++;
 }
 
+template<typename K, typename... GlobalSchema>
+void decrement_count(WitnessMap<K>& map, const K& key) {
+    map.decrement(key);
+}
+
+template<typename K, typename... GlobalSchema>
+void increment_count(WitnessMap<K>& map, const K& key) {
+    map.increment(key);
+}
+
 // reset lemma - removes monotonicity and other terms from Shannon inequality while maintaining inequality
+// - only changes the symbolic state; the dictionaries the lemma consumes are appended to dict_pops
+//   (each pop removes the last dictionary of that monotonicity)
+// - nothing when no case matches (see apply_symbolic_reset_lemma)
 template<typename... GlobalSchema>
-Subproblem<GlobalSchema...> apply_reset_lemma(const Subproblem<GlobalSchema...>& subproblem,
-    const Monotonicity<GlobalSchema...>& monotonicity) {
-    
-    std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D_ = subproblem.D;
+std::optional<SymbolicState<GlobalSchema...>> try_symbolic_reset_lemma(const SymbolicState<GlobalSchema...>& state,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    std::vector<Monotonicity<GlobalSchema...>>& dict_pops) {
+
+    WitnessMap<Monotonicity<GlobalSchema...>> D_ = state.D;
     decrement_count(D_, monotonicity);
 
     // Case 0: W in Z (base case)
-    for (const auto& [output_attrs, count] : subproblem.Z) {
-        if (monotonicity.attrs_Y == output_attrs && monotonicity.attrs_X == NULL_ATTR<GlobalSchema...>) {
-            // remove Z
-            std::unordered_map<OutputAttributes<GlobalSchema...>, unsigned> Z_ = subproblem.Z;
-            decrement_count(Z_, output_attrs);
-            Subproblem<GlobalSchema...> retry_subproblem = Subproblem(
-                Z_,
-                D_,
-                subproblem.Tn_tables,
-                subproblem.Tn_dicts,
-                subproblem.M,
-                subproblem.S,
-                subproblem.global_bound);
-            return retry_subproblem;
-        }
+    if (state.Z.count(monotonicity.attrs_Y) > 0 && monotonicity.attrs_X == NULL_ATTR<GlobalSchema...>) {
+        // remove Z
+        std::unordered_map<OutputAttributes<GlobalSchema...>, unsigned> Z_ = state.Z;
+        decrement_count(Z_, monotonicity.attrs_Y);
+        return std::optional(SymbolicState<GlobalSchema...>{Z_, D_, state.M, state.S});
     }
-    
+
     // Case 1: Y|W in D (inductive case)
-    for (const auto& [condition_monotonicity, count] : subproblem.D) {
-        if (monotonicity.attrs_Y == condition_monotonicity.attrs_X) {
-            // remove Y|W, add YW|0 to D
-            std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> D_ = subproblem.D;
-            Monotonicity<GlobalSchema...> mon_YW = Monotonicity<GlobalSchema...>{
-                condition_monotonicity.attrs_X ^ condition_monotonicity.attrs_Y,
-                NULL_ATTR<GlobalSchema...>,
-            };
-            decrement_count(D_, condition_monotonicity);
-            increment_count(D_, mon_YW);
-
-            // remove Y|W from dicts
-            std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Dictionary<GlobalSchema...>, Constraint>>> Tn_dicts_ = subproblem.Tn_dicts;
-            std::pair<Dictionary<GlobalSchema...>, Constraint> Tn_dict_Y_W = Tn_dicts_[condition_monotonicity].back();
-            Tn_dicts_[condition_monotonicity].pop_back();
-
-            // retry reset to remove YW|0
-            Subproblem<GlobalSchema...> retry_subproblem = Subproblem(
-                subproblem.Z,
-                D_,
-                subproblem.Tn_tables,
-                Tn_dicts_,
-                subproblem.M,
-                subproblem.S,
-                subproblem.global_bound);
-            return apply_reset_lemma(retry_subproblem, mon_YW);
-        }
+    const std::vector<Monotonicity<GlobalSchema...>>& condition_monotonicities = state.D.by_X(monotonicity.attrs_Y);
+    if (!condition_monotonicities.empty()) {
+        const Monotonicity<GlobalSchema...>& condition_monotonicity = condition_monotonicities.front();
+        // remove Y|W, add YW|0 to D
+        WitnessMap<Monotonicity<GlobalSchema...>> D_ = state.D;
+        Monotonicity<GlobalSchema...> mon_YW = Monotonicity<GlobalSchema...>{
+            condition_monotonicity.attrs_X ^ condition_monotonicity.attrs_Y,
+            NULL_ATTR<GlobalSchema...>,
+        };
+        decrement_count(D_, condition_monotonicity);
+        increment_count(D_, mon_YW);
+
+        // remove Y|W from dicts
+        dict_pops.push_back(condition_monotonicity);
+
+        // retry reset to remove YW|0
+        return try_symbolic_reset_lemma(SymbolicState<GlobalSchema...>{state.Z, D_, state.M, state.S}, mon_YW, dict_pops);
     }
 
     // Case 2: W = XY and Y|X in M (inductive case)
-    for (const auto& [witness_monotonicity, count] : subproblem.M) {
-        if (monotonicity.attrs_Y == (witness_monotonicity.attrs_X ^ witness_monotonicity.attrs_Y)) {
-
-            // remove Y|X from M
-            std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> M_ = subproblem.M;
-            decrement_count(M_, witness_monotonicity);
-
-            // add X to D
-            Monotonicity<GlobalSchema...> mon_X = Monotonicity<GlobalSchema...>{
-                witness_monotonicity.attrs_X,
-                NULL_ATTR<GlobalSchema...>,
-            };
-            increment_count(D_, mon_X);
-
-            // retry reset to remove X|0
-            Subproblem<GlobalSchema...> retry_subproblem = Subproblem(
-                subproblem.Z,
-                D_,
-                subproblem.Tn_tables,
-                subproblem.Tn_dicts,
-                M_,
-                subproblem.S,
-                subproblem.global_bound);
-            return apply_reset_lemma(retry_subproblem, mon_X);
-        }
+    const std::vector<Monotonicity<GlobalSchema...>>& witness_monotonicities = state.M.by_XY(monotonicity.attrs_Y);
+    if (!witness_monotonicities.empty()) {
+        const Monotonicity<GlobalSchema...>& witness_monotonicity = witness_monotonicities.front();
+
+        // remove Y|X from M
+        WitnessMap<Monotonicity<GlobalSchema...>> M_ = state.M;
+        decrement_count(M_, witness_monotonicity);
+
+        // add X to D
+        Monotonicity<GlobalSchema...> mon_X = Monotonicity<GlobalSchema...>{
+            witness_monotonicity.attrs_X,
+            NULL_ATTR<GlobalSchema...>,
+        };
+        increment_count(D_, mon_X);
+
+        // retry reset to remove X|0
+        return try_symbolic_reset_lemma(SymbolicState<GlobalSchema...>{state.Z, D_, M_, state.S}, mon_X, dict_pops);
     }
 
     // Case 3: W = XY and Y;Z|X in S (inductive case)
-    for (const auto& [witness_submodularity, count] : subproblem.S) {
-        if (monotonicity.attrs_Y == (witness_submodularity.attrs_X ^ witness_submodularity.attrs_Y)) {
-
-            // remove Y;Z|X from S
-            std::unordered_map<Submodularity<GlobalSchema...>, unsigned> S_ = subproblem.S;
-            decrement_count(S_, witness_submodularity);
-
-            // add XYZ to D and add Z|X to M
-            Monotonicity<GlobalSchema...> mon_XYZ = Monotonicity<GlobalSchema...>{
-                witness_submodularity.attrs_X ^ witness_submodularity.attrs_Y ^ witness_submodularity.attrs_Z,
-                NULL_ATTR<GlobalSchema...>,
-            };
-            increment_count(D_, mon_XYZ);
-            std::unordered_map<Monotonicity<GlobalSchema...>, unsigned> M_ = subproblem.M;
-            Monotonicity<GlobalSchema...> mon_Z_X = Monotonicity<GlobalSchema...>{
-                witness_submodularity.attrs_Z,
-                witness_submodularity.attrs_X,
-            };
-            increment_count(M_, mon_Z_X);
-
-            // retry reset to remove XYZ
-            Subproblem<GlobalSchema...> retry_subproblem = Subproblem(
-                subproblem.Z,
-                D_,
-                subproblem.Tn_tables,
-                subproblem.Tn_dicts,
-                M_,
-                S_,
-                subproblem.global_bound);
-            return apply_reset_lemma(retry_subproblem, mon_XYZ);
-        }
+    const std::vector<Submodularity<GlobalSchema...>>& witness_submodularities = state.S.by_XY(monotonicity.attrs_Y);
+    if (!witness_submodularities.empty()) {
+        const Submodularity<GlobalSchema...>& witness_submodularity = witness_submodularities.front();
+
+        // remove Y;Z|X from S
+        WitnessMap<Submodularity<GlobalSchema...>> S_ = state.S;
+        decrement_count(S_, witness_submodularity);
+
+        // add XYZ to D and add Z|X to M
+        Monotonicity<GlobalSchema...> mon_XYZ = Monotonicity<GlobalSchema...>{
+            witness_submodularity.attrs_X ^ witness_submodularity.attrs_Y ^ witness_submodularity.attrs_Z,
+            NULL_ATTR<GlobalSchema...>,
+        };
+        increment_count(D_, mon_XYZ);
+        WitnessMap<Monotonicity<GlobalSchema...>> M_ = state.M;
+        Monotonicity<GlobalSchema...> mon_Z_X = Monotonicity<GlobalSchema...>{
+            witness_submodularity.attrs_Z,
+            witness_submodularity.attrs_X,
+        };
+        increment_count(M_, mon_Z_X);
+
+        // retry reset to remove XYZ
+        return try_symbolic_reset_lemma(SymbolicState<GlobalSchema...>{state.Z, D_, M_, S_}, mon_XYZ, dict_pops);
     }
-    
-    throw std::runtime_error("No case matched reset lemma subproblem");
+
+    return std::nullopt;
+}
+
+template<typename... GlobalSchema>
+SymbolicState<GlobalSchema...> apply_symbolic_reset_lemma(const SymbolicState<GlobalSchema...>& state,
+    const Monotonicity<GlobalSchema...>& monotonicity,
+    std::vector<Monotonicity<GlobalSchema...>>& dict_pops) {
+    std::optional<SymbolicState<GlobalSchema...>> reset_state = try_symbolic_reset_lemma(state, monotonicity, dict_pops);
+    if (!reset_state) {
+        throw std::runtime_error("No case matched reset lemma subproblem");
+    }
+    return std::move(*reset_state);
+}
+
+// removes the dictionaries consumed by the reset lemma
+template<typename... GlobalSchema>
+std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> pop_dicts(
+    std::unordered_map<Monotonicity<GlobalSchema...>, std::vector<std::pair<Shared<Dictionary<GlobalSchema...>>, Constraint>>> Tn_dicts,
+    const std::vector<Monotonicity<GlobalSchema...>>& dict_pops) {
+    for (const auto& monotonicity : dict_pops) {
+        Tn_dicts[monotonicity].pop_back();
+    }
+    return Tn_dicts;
+}
+
+template<typename... GlobalSchema>
+Subproblem<GlobalSchema...> apply_reset_lemma(const Subproblem<GlobalSchema...>& subproblem,
+    const Monotonicity<GlobalSchema...>& monotonicity) {
+    std::vector<Monotonicity<GlobalSchema...>> dict_pops;
+    SymbolicState<GlobalSchema...> state = apply_symbolic_reset_lemma(subproblem.symbolic_state(), monotonicity, dict_pops);
+    return Subproblem(
+        std::move(state.Z),
+        std::move(state.D),
+        subproblem.Tn_tables,
+        pop_dicts(subproblem.Tn_dicts, dict_pops),
+        std::move(state.M),
+        std::move(state.S),
+        subproblem.global_bound,
+        subproblem.arena);
 }
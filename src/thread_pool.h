@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// work-stealing thread pool - each worker pushes and pops tasks at the back of its own deque (depth first)
+// and steals from the front of the other workers' deques (oldest, usually largest, tasks) when it runs dry
+// - worker 0 is the thread calling wait(), workers 1..size()-1 are pool threads
+class WorkStealingPool {
+public:
+    using Task = std::function<void(std::size_t worker)>;
+
+    explicit WorkStealingPool(std::size_t num_threads) : queues(std::max<std::size_t>(num_threads, 1)) {
+        for (auto& queue : queues) {
+            queue = std::make_unique<WorkerQueue>();
+        }
+        for (std::size_t worker = 1; worker < queues.size(); worker++) {
+            threads.emplace_back([this, worker]() { run_worker(worker); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stop = true;
+        }
+        sleep_cv.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    std::size_t size() const {
+        return queues.size();
+    }
+
+    // queue a task on a worker's deque - tasks submitting follow-up work pass the worker running them
+    void submit(Task task, std::size_t worker = 0) {
+        pending++;
+        {
+            // counted under the deque lock before the push, so a thief popping the task never finds queued at 0
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            queued++;
+            queues[worker]->tasks.push_back(std::move(task));
+        }
+        {
+            // a worker checks queued under sleep_mutex, so it has either seen the task or is waiting for the notify
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+        }
+        sleep_cv.notify_one();
+    }
+
+    // runs tasks on the calling thread until every submitted task (and every task they submit) has finished
+    // - rethrows the first exception thrown by a task
+    void wait() {
+        while (true) {
+            std::optional<Task> task = take(0);
+            if (task) {
+                execute(*task, 0);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleep_cv.wait(lock, [this]() { return queued > 0 || pending == 0; });
+            if (pending == 0) {
+                break;
+            }
+        }
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::swap(error, first_error);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    // tasks submitted but not finished / tasks sitting in a deque
+    std::atomic<std::size_t> pending{0};
+    std::atomic<std::size_t> queued{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool stop = false;
+
+    std::mutex error_mutex;
+    std::exception_ptr first_error;
+
+    std::optional<Task> take(std::size_t worker) {
+        {
+            WorkerQueue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                Task task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queued--;
+                return task;
+            }
+        }
+        for (std::size_t offset = 1; offset < queues.size(); offset++) {
+            WorkerQueue& victim = *queues[(worker + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                Task task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued--;
+                return task;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void execute(Task& task, std::size_t worker) {
+        try {
+            task(worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!first_error) {
+                first_error = std::current_exception();
+            }
+        }
+        if (--pending == 0) {
+            // wake the thread blocked in wait()
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            sleep_cv.notify_all();
+        }
+    }
+
+    void run_worker(std::size_t worker) {
+        while (true) {
+            std::optional<Task> task = take(worker);
+            if (task) {
+                execute(*task, worker);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleep_cv.wait(lock, [this]() { return queued > 0 || stop; });
+            if (stop) {
+                return;
+            }
+        }
+    }
+};
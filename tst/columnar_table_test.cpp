@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <bitset>
+#include <any>
+#include <cmath>
+
+#include "src/model/columnar_table.h"
+#include "src/model/table.h"
+#include "src/model/row.h"
+#include "tst/test_utils.h"
+
+Table<int, double, double> create_columnar_test_table() {
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            std::size_t copies = (i == 0) ? 9 : 1;
+            for (std::size_t k = 0; k < copies; k++) {
+                std::array<std::any, 3> row = {
+                    std::any((int) i),
+                    std::any((double) j),
+                    std::any((double) 10.0 * i + j + k)
+                };
+                data.insert(create_row<int, double, double>(row));
+            }
+        }
+    }
+    return Table<int, double, double>{data, std::bitset<3>("111")};
+}
+
+TEST(ColumnarTableTest, RoundTripTest) {
+    Table<int, double, double> table = create_columnar_test_table();
+    ColumnarTable<int, double, double> columnar = to_columnar(table);
+    EXPECT_EQ(columnar.size(), table.data.size());
+    EXPECT_EQ(to_table(columnar).data, table.data);
+}
+
+TEST(ColumnarTableTest, ProjectTest) {
+    Table<int, double, double> table = create_columnar_test_table();
+    ColumnarTable<int, double, double> columnar = to_columnar(table);
+    auto proj_attrs = std::bitset<3>("011");
+    ColumnarTable<int, double, double> proj = project(columnar, proj_attrs);
+    EXPECT_EQ(proj.attributes, proj_attrs);
+    EXPECT_TRUE(std::get<2>(proj.columns).empty());
+    EXPECT_EQ(to_table(proj).data, project(table, proj_attrs).data);
+}
+
+TEST(ColumnarTableTest, ConstructionJoinTest) {
+    Table<int, double, double> table = create_columnar_test_table();
+    ColumnarTable<int, double, double> columnar = to_columnar(table);
+    auto attrs_X = std::bitset<3>("011");
+    auto attrs_Y = std::bitset<3>("100");
+    ColumnarDictionary<int, double, double> dict = construction(columnar, attrs_X, attrs_Y);
+    EXPECT_EQ(dict.keys.size(), 9);
+    EXPECT_EQ(dict.payload.size(), table.data.size());
+
+    ColumnarTable<int, double, double> keys = project(columnar, attrs_X);
+    ColumnarTable<int, double, double> joined = join(keys, dict);
+    EXPECT_EQ(to_table(joined).data, table.data);
+
+    Dictionary<int, double, double> row_dict = construction(table, attrs_X, attrs_Y);
+    EXPECT_EQ(to_table(joined).data, join(project(table, attrs_X), row_dict).data);
+}
+
+TEST(ColumnarTableTest, PartitionTest) {
+    Table<int, double, double> table = create_columnar_test_table();
+    ColumnarTable<int, double, double> columnar = to_columnar(table);
+    auto partition_attrs = std::bitset<3>("001");
+    std::vector<ColumnarView<int, double, double>> views = partition(columnar, partition_attrs);
+
+    // every row is selected exactly once and all rows of a view share the same log degree
+    std::vector<std::size_t> selected(columnar.size(), 0);
+    ColumnarDictionary<int, double, double> dict = construction(columnar, partition_attrs, std::bitset<3>("110"));
+    for (const auto& view : views) {
+        std::unordered_set<unsigned> log_degrees;
+        for (uint32_t row : view.selection) {
+            selected[row]++;
+            ColumnarRowRef<int, double, double> ref{columnar, row};
+            uint32_t key = columnar_find(dict.keys, ref, columnar_hash<ColumnarRowRef<int, double, double>, int, double, double>(partition_attrs, ref));
+            ASSERT_NE(key, (ColumnarTable<int, double, double>::NO_ROW));
+            log_degrees.insert(std::ceil(log2(dict.offsets[key + 1] - dict.offsets[key])));
+        }
+        EXPECT_EQ(log_degrees.size(), 1);
+    }
+    for (std::size_t count : selected) {
+        EXPECT_EQ(count, 1);
+    }
+    EXPECT_EQ(views.size(), partition(table, partition_attrs).size());
+
+    // other strategies assign the same rows as the row-based partition
+    PartitionStrategy heavy_light;
+    heavy_light.mode = PartitionMode::HEAVY_LIGHT;
+    PartitionStrategy unsplit;
+    unsplit.split_classes = false;
+    unsplit.coalesce_rows = 10;
+    for (const PartitionStrategy& strategy : {heavy_light, unsplit}) {
+        std::vector<std::size_t> view_sizes;
+        for (const auto& view : partition(columnar, partition_attrs, strategy)) {
+            view_sizes.push_back(view.size());
+        }
+        std::vector<std::size_t> table_sizes;
+        for (const auto& partitioned_table : partition(table, partition_attrs, strategy)) {
+            table_sizes.push_back(partitioned_table.data.size());
+        }
+        std::sort(view_sizes.begin(), view_sizes.end());
+        std::sort(table_sizes.begin(), table_sizes.end());
+        EXPECT_EQ(view_sizes, table_sizes);
+    }
+}
+
+TEST(ColumnarTableTest, ConstructionDeduplicatesProjectedRows) {
+    // the third column is outside XY, so Y values repeat within a key
+    Table<int, double, double> table = create_columnar_test_table();
+    ColumnarTable<int, double, double> columnar = to_columnar(table);
+    auto attrs_X = std::bitset<3>("001");
+    auto attrs_Y = std::bitset<3>("010");
+    ColumnarDictionary<int, double, double> dict = construction(columnar, attrs_X, attrs_Y);
+    Dictionary<int, double, double> row_dict = construction(table, attrs_X, attrs_Y);
+    EXPECT_EQ(dict.keys.size(), 3);
+    EXPECT_EQ(dict.payload.size(), 9);
+    for (uint32_t key = 0; key < dict.keys.size(); key++) {
+        EXPECT_EQ(dict.offsets[key + 1] - dict.offsets[key], 3);
+    }
+    EXPECT_EQ(degree(row_dict), 3);
+
+    ColumnarTable<int, double, double> joined = join(project(columnar, attrs_X), dict);
+    EXPECT_EQ(joined.size(), 9);
+    EXPECT_EQ(to_table(joined).data, join(project(table, attrs_X), row_dict).data);
+}
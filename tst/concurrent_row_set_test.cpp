@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <any>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "src/model/concurrent_row_set.h"
+#include "src/model/table.h"
+#include "tst/test_utils.h"
+
+HashableRow<int, int, double> concurrent_test_row(int value) {
+    std::array<std::any, 3> row = {std::any(value), std::any(value % 7), std::any()};
+    return create_row<int, int, double>(row);
+}
+
+TEST(ConcurrentRowSetTest, ConcurrentInsertsWithGrowth) {
+    // every value is inserted by two threads, starting from the smallest array so it grows many times
+    constexpr int VALUE_COUNT = 50000;
+    constexpr int THREAD_COUNT = 8;
+    ConcurrentRowSet<int, int, double> rows;
+    std::atomic<int> inserted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&rows, &inserted, t]() {
+            for (int value = 0; value < VALUE_COUNT; value++) {
+                if (value % (THREAD_COUNT / 2) == t % (THREAD_COUNT / 2)) {
+                    inserted += rows.insert(concurrent_test_row(value));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(inserted, VALUE_COUNT);
+    EXPECT_EQ(rows.size(), VALUE_COUNT);
+    EXPECT_GE(rows.capacity(), 2 * VALUE_COUNT);
+    std::vector<int> seen(VALUE_COUNT, 0);
+    for (const auto& row : rows) {
+        seen[row.get<0>()]++;
+    }
+    for (int value = 0; value < VALUE_COUNT; value++) {
+        EXPECT_EQ(seen[value], 1);
+        EXPECT_TRUE(rows.contains(concurrent_test_row(value)));
+    }
+    EXPECT_FALSE(rows.contains(concurrent_test_row(VALUE_COUNT)));
+    EXPECT_FALSE(rows.insert(concurrent_test_row(0)));
+}
+
+TEST(ConcurrentRowSetTest, LookupsDuringGrowth) {
+    // writers publish how far they have inserted, and readers look up rows below that while the set keeps growing
+    constexpr int VALUE_COUNT = 50000;
+    constexpr int WRITER_COUNT = 4;
+    ConcurrentRowSet<int, int, double> rows;
+    std::array<std::atomic<int>, WRITER_COUNT> progress{};
+    std::atomic<int> missed{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITER_COUNT; w++) {
+        threads.emplace_back([&rows, &progress, w]() {
+            for (int value = w; value < VALUE_COUNT; value += WRITER_COUNT) {
+                rows.insert(concurrent_test_row(value));
+                progress[w].store(value + 1, std::memory_order_release);
+            }
+        });
+    }
+    for (int r = 0; r < 4; r++) {
+        threads.emplace_back([&rows, &progress, &missed, r]() {
+            for (int i = 0; i < VALUE_COUNT; i++) {
+                int inserted = progress[(i + r) % WRITER_COUNT].load(std::memory_order_acquire);
+                if (inserted > 0 && !rows.contains(concurrent_test_row(inserted - 1))) {
+                    missed++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(missed, 0);
+    EXPECT_EQ(rows.size(), VALUE_COUNT);
+}
+
+TEST(ConcurrentRowSetTest, MovedFromSetRefills) {
+    static_assert(std::is_nothrow_move_constructible_v<ConcurrentRowSet<int, int, double>>);
+    ConcurrentRowSet<int, int, double> rows;
+    rows.insert(concurrent_test_row(1));
+    ConcurrentRowSet<int, int, double> moved(std::move(rows));
+    EXPECT_EQ(moved.size(), 1);
+    EXPECT_TRUE(moved.contains(concurrent_test_row(1)));
+
+    // the moved-from set has no array until an insert installs one
+    EXPECT_TRUE(rows.empty());
+    EXPECT_EQ(rows.capacity(), 0);
+    EXPECT_TRUE(rows.begin() == rows.end());
+    EXPECT_FALSE(rows.contains(concurrent_test_row(1)));
+    rows.prefetch(concurrent_test_row(1));
+
+    // racing first inserts agree on one array
+    constexpr int VALUE_COUNT = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&rows]() {
+            for (int value = 0; value < VALUE_COUNT; value++) {
+                rows.insert(concurrent_test_row(value));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(rows.size(), VALUE_COUNT);
+    EXPECT_EQ(std::distance(rows.begin(), rows.end()), VALUE_COUNT);
+
+    moved = std::move(rows);
+    EXPECT_EQ(moved.size(), VALUE_COUNT);
+}
+
+TEST(ConcurrentRowSetTest, TableBackendsAreInterchangeable) {
+    Table<int, int, double> table{RowSet<int, int, double>(), std::bitset<3>("011")};
+    ConcurrentTable<int, int, double> concurrent_table{ConcurrentRowSet<int, int, double>(), std::bitset<3>("011")};
+    for (int value = 0; value < 1000; value++) {
+        table.data.insert(concurrent_test_row(value));
+        concurrent_table.data.insert(concurrent_test_row(value));
+    }
+    EXPECT_EQ(content_hash(concurrent_table), content_hash(table));
+
+    // operators read either backend
+    EXPECT_EQ(project(concurrent_table, std::bitset<3>("010")).data, project(table, std::bitset<3>("010")).data);
+    Dictionary<int, int, double> dict = construction(table, std::bitset<3>("010"), std::bitset<3>("001"));
+    EXPECT_TRUE(same_content(construction(concurrent_table, std::bitset<3>("010"), std::bitset<3>("001")), dict));
+    Table<int, int, double> probe = project(table, std::bitset<3>("010"));
+    EXPECT_EQ(join(probe, dict).data, table.data);
+
+    // and union into either backend
+    Table<int, int, double> copied{RowSet<int, int, double>(), table.attributes};
+    inplace_union(copied, concurrent_table);
+    EXPECT_EQ(copied.data, table.data);
+    inplace_union(concurrent_table, table);
+    EXPECT_EQ(concurrent_table.data.size(), table.data.size());
+}
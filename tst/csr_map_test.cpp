@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+#include "src/model/csr_map.h"
+#include "src/model/table.h"
+#include "tst/test_utils.h"
+
+TEST(CsrMapTest, GroupsAreContiguous) {
+    CsrMap<int, double, double> map;
+    std::vector<HashableRow<int, double, double>> keys;
+    for (std::size_t i = 0; i < 3; i++) {
+        std::array<std::any, 3> key = {std::any((int) i), std::any(), std::any()};
+        keys.push_back(create_row<int, double, double>(key));
+        map.open_group();
+        for (std::size_t j = 0; j <= i; j++) {
+            std::array<std::any, 3> value = {std::any(), std::any((double) j), std::any()};
+            map.push_row(create_row<int, double, double>(value));
+        }
+        map.close_group(keys.back());
+    }
+
+    EXPECT_EQ(map.size(), 3);
+    EXPECT_EQ(map.row_count(), 6);
+    EXPECT_EQ(map.degree(), 3);
+    for (std::size_t i = 0; i < 3; i++) {
+        CsrMap<int, double, double>::Rows rows = map.at(keys[i]);
+        EXPECT_EQ(rows.size(), i + 1);
+        EXPECT_EQ(rows.end() - rows.begin(), (std::ptrdiff_t) i + 1);
+    }
+    std::array<std::any, 3> missing = {std::any((int) 7), std::any(), std::any()};
+    EXPECT_TRUE(map.find(create_row<int, double, double>(missing)).empty());
+    EXPECT_EQ(map.count(create_row<int, double, double>(missing)), 0);
+    EXPECT_THROW(map.close_group(keys[0]), std::logic_error);
+}
+
+TEST(CsrMapTest, ConstructionDeduplicatesProjectedRows) {
+    // XYZ rows whose Y projections repeat for the same X
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 8; i++) {
+        std::array<std::any, 3> row = {std::any((int) i % 2), std::any((double) (i / 4)), std::any((double) i)};
+        data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> table{data, std::bitset<3>("111")};
+    BaseDictionary<int, double, double> dict = std::get<BaseDictionary<int, double, double>>(
+        construction(table, std::bitset<3>("001"), std::bitset<3>("010")));
+    EXPECT_EQ(dict.construction_map.size(), 2);
+    EXPECT_EQ(dict.construction_map.row_count(), 4);
+    EXPECT_EQ(degree(dict), 2);
+
+    // equality ignores the order of the rows of a key
+    CsrMap<int, double, double> copy(dict.construction_map, std::pmr::new_delete_resource());
+    EXPECT_TRUE(copy == dict.construction_map);
+}
+
+TEST(CsrMapTest, HeavyKeyEquality) {
+    // one key with many rows, pushed in opposite orders
+    std::array<std::any, 3> key = {std::any((int) 1), std::any(), std::any()};
+    auto build = [&key](int first, int last, int step) {
+        CsrMap<int, double, double> map;
+        map.open_group();
+        for (int j = first; j != last; j += step) {
+            std::array<std::any, 3> value = {std::any(), std::any((double) j), std::any()};
+            map.push_row(create_row<int, double, double>(value));
+        }
+        map.close_group(create_row<int, double, double>(key));
+        return map;
+    };
+    CsrMap<int, double, double> forward = build(0, 1000, 1);
+    EXPECT_TRUE(forward == build(999, -1, -1));
+    EXPECT_FALSE(forward == build(1, 1001, 1));
+}
+
+TEST(CsrMapTest, MovesLeaveNoStorage) {
+    static_assert(std::is_nothrow_move_constructible_v<CsrMap<int, double, double>>);
+    static_assert(std::is_nothrow_move_assignable_v<CsrMap<int, double, double>>);
+    std::array<std::any, 3> key = {std::any((int) 1), std::any(), std::any()};
+    std::array<std::any, 3> value = {std::any(), std::any((double) 2.0), std::any()};
+    std::pmr::monotonic_buffer_resource arena;
+    CsrMap<int, double, double> map(&arena);
+    map.open_group();
+    map.push_row(create_row<int, double, double>(value));
+    map.close_group(create_row<int, double, double>(key));
+
+    // the storage moves with the handle, and the moved-from map reads as empty with no storage of its own
+    CsrMap<int, double, double> moved(std::move(map));
+    EXPECT_EQ(moved.size(), 1);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.degree(), 0);
+    EXPECT_EQ(map.row_count(), 0);
+    EXPECT_TRUE(map.find(create_row<int, double, double>(key)).empty());
+    EXPECT_TRUE(map.begin() == map.end());
+    EXPECT_TRUE((map.shares_storage(CsrMap<int, double, double>())));
+    EXPECT_TRUE((map == CsrMap<int, double, double>()));
+    EXPECT_FALSE(map == moved);
+
+    // and is rebuilt on its resource
+    EXPECT_EQ(map.resource(), &arena);
+    map.open_group();
+    map.push_row(create_row<int, double, double>(value));
+    map.close_group(create_row<int, double, double>(key));
+    EXPECT_TRUE(map == moved);
+    moved = std::move(map);
+    EXPECT_EQ(moved.size(), 1);
+    EXPECT_TRUE(map.empty());
+}
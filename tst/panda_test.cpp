@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
@@ -123,7 +124,7 @@ TEST(GenerateSubproblemSubnodesTest, Case1_1_ConditionMonotonicityWithinBounds)
     Monotonicity<int, double, double> mon_W = {W, NULL_ATTR<int, double, double>};
     Monotonicity<int, double, double> mon_Y_W = {Y, W};
 
-    std::unordered_set<HashableRow<int, double, double>> data_W;
+    RowSet<int, double, double> data_W;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i % 2),
@@ -133,7 +134,7 @@ TEST(GenerateSubproblemSubnodesTest, Case1_1_ConditionMonotonicityWithinBounds)
         HashableRow<int, double, double> row_obj = create_row<int, double, double>(row);
         data_W.insert(row_obj);
     }
-    std::unordered_map<HashableRow<int, double, double>, std::unordered_set<HashableRow<int, double, double>>> map_Y_W;
+    RowMap<int, double, double> map_Y_W;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> key = {
             std::any((int) i),
@@ -141,7 +142,7 @@ TEST(GenerateSubproblemSubnodesTest, Case1_1_ConditionMonotonicityWithinBounds)
             std::any()
         };
         auto key_row = create_row<int, double, double>(key);
-        map_Y_W[key_row] = std::unordered_set<HashableRow<int, double, double>>();
+        map_Y_W[key_row] = RowSet<int, double, double>();
 
         std::array<std::any, 3> value = {
             std::any(),
@@ -160,10 +161,10 @@ TEST(GenerateSubproblemSubnodesTest, Case1_1_ConditionMonotonicityWithinBounds)
         {mon_W, 1},
         {mon_Y_W, 1}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Table<int, double, double>, Constraint>>> Tn_tables = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
         {mon_W, {{table_W, 2.0}}}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Dictionary<int, double, double>, Constraint>>> Tn_dicts = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Dictionary<int, double, double>>, Constraint>>> Tn_dicts = {
         {mon_Y_W, {{dict_Y_W, 2.0}}}
     };
     Subproblem<int, double, double> initial_subproblem(
@@ -204,7 +205,7 @@ TEST(GenerateSubproblemSubnodesTest, Case1_2_ConditionMonotonicityExceedsBounds_
     Monotonicity<int, double, double> mon_Y_W = {Y, W};  // Y|W
     OutputAttributes<int, double, double> attrs_YW = Y ^ W;
     
-    std::unordered_set<HashableRow<int, double, double>> data_W;
+    RowSet<int, double, double> data_W;
     for (std::size_t i = 0; i < 4; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -213,9 +214,9 @@ TEST(GenerateSubproblemSubnodesTest, Case1_2_ConditionMonotonicityExceedsBounds_
         };
         data_W.insert(create_row<int, double, double>(row));
     }
-    std::unordered_map<HashableRow<int, double, double>, std::unordered_set<HashableRow<int, double, double>>> map_Y_W;
+    RowMap<int, double, double> map_Y_W;
     for (const auto& w_row : data_W) {
-        map_Y_W[w_row] = std::unordered_set<HashableRow<int, double, double>>();
+        map_Y_W[w_row] = RowSet<int, double, double>();
         for (std::size_t i = 0; i < 3; i++) {
             std::array<std::any, 3> value = {
                 std::any(),
@@ -236,10 +237,10 @@ TEST(GenerateSubproblemSubnodesTest, Case1_2_ConditionMonotonicityExceedsBounds_
         {mon_W, 1},
         {mon_Y_W, 1}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Table<int, double, double>, Constraint>>> Tn_tables = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
         {mon_W, {{table_W, 4.0}}}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Dictionary<int, double, double>, Constraint>>> Tn_dicts = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Dictionary<int, double, double>>, Constraint>>> Tn_dicts = {
         {mon_Y_W, {{dict_Y_W, 3.0}}}
     };
     
@@ -286,7 +287,7 @@ TEST(GenerateSubproblemSubnodesTest, Case1_2_ConditionMonotonicityExceedsBounds_
     Monotonicity<int, double, double> mon_Y_W = {Y, W};
     Monotonicity<int, double, double> mon_B_A = {B, A};
     
-    std::unordered_set<HashableRow<int, double, double>> data_W;
+    RowSet<int, double, double> data_W;
     for (std::size_t i = 0; i < 4; i++) {
         std::array<std::any, 3> row = {
             std::any(),
@@ -295,9 +296,9 @@ TEST(GenerateSubproblemSubnodesTest, Case1_2_ConditionMonotonicityExceedsBounds_
         };
         data_W.insert(create_row<int, double, double>(row));
     }
-    std::unordered_map<HashableRow<int, double, double>, std::unordered_set<HashableRow<int, double, double>>> map_Y_W;
+    RowMap<int, double, double> map_Y_W;
     for (const auto& w_row : data_W) {
-        map_Y_W[w_row] = std::unordered_set<HashableRow<int, double, double>>();
+        map_Y_W[w_row] = RowSet<int, double, double>();
         for (std::size_t i = 0; i < 3; i++) {
             std::array<std::any, 3> value = {
                 std::any((int) i),
@@ -321,10 +322,10 @@ TEST(GenerateSubproblemSubnodesTest, Case1_2_ConditionMonotonicityExceedsBounds_
     std::unordered_map<Monotonicity<int, double, double>, unsigned> M = {
         {mon_B_A, 1}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Table<int, double, double>, Constraint>>> Tn_tables = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
         {mon_W, {{table_W, 4.0}}}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Dictionary<int, double, double>, Constraint>>> Tn_dicts = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Dictionary<int, double, double>>, Constraint>>> Tn_dicts = {
         {mon_Y_W, {{dict_Y_W, 3.0}}}
     };
     Subproblem<int, double, double> initial_subproblem(
@@ -366,7 +367,7 @@ TEST(GenerateSubproblemSubnodesTest, Case2_SplitMonotonicity) {
     Monotonicity<int, double, double> mon_XY = {X ^ Y, NULL_ATTR<int, double, double>};
     Monotonicity<int, double, double> mon_Y_X = {Y, X};
 
-    std::unordered_set<HashableRow<int, double, double>> data_XY;
+    RowSet<int, double, double> data_XY;
     for (std::size_t i = 0; i < 4; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -383,7 +384,7 @@ TEST(GenerateSubproblemSubnodesTest, Case2_SplitMonotonicity) {
     std::unordered_map<Monotonicity<int, double, double>, unsigned> M = {
         {mon_Y_X, 1}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Table<int, double, double>, Constraint>>> Tn_tables = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
         {mon_XY, {{table_XY, 4.0}}}
     };
     Subproblem<int, double, double> initial_subproblem(
@@ -416,6 +417,61 @@ TEST(GenerateSubproblemSubnodesTest, Case2_SplitMonotonicity) {
     );
 }
 
+// Case 2: child subproblems share the tables they do not change and keep the tables they add alive
+TEST(GenerateSubproblemSubnodesTest, Case2_SplitSharesUnchangedTables) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_XY = {X ^ Y, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_Z = {Z, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_Y_X = {Y, X};
+
+    RowSet<int, double, double> data_XY;
+    RowSet<int, double, double> data_Z;
+    for (std::size_t i = 0; i < 4; i++) {
+        std::array<std::any, 3> row_XY = {
+            std::any((int) i),
+            std::any((double) i * 2.0),
+            std::any()
+        };
+        std::array<std::any, 3> row_Z = {
+            std::any(),
+            std::any(),
+            std::any((double) i)
+        };
+        data_XY.insert(create_row<int, double, double>(row_XY));
+        data_Z.insert(create_row<int, double, double>(row_Z));
+    }
+    Table<int, double, double> table_XY{data_XY, X ^ Y};
+    Table<int, double, double> table_Z{data_Z, Z};
+
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
+        {mon_XY, {{table_XY, 4.0}}},
+        {mon_Z, {{table_Z, 4.0}}}
+    };
+    std::optional<Subproblem<int, double, double>> initial_subproblem = Subproblem<int, double, double>(
+        {},
+        {{mon_XY, 1}, {mon_Z, 1}},
+        Tn_tables,
+        {},
+        {{mon_Y_X, 1}},
+        {},
+        10.0
+    );
+    Subproblem<int, double, double> subnode = generate_split_subproblem(*initial_subproblem, mon_XY, mon_Y_X);
+
+    const Table<int, double, double>* parent_Z = &*initial_subproblem->Tn_tables.at(mon_Z).at(0).first;
+    const Table<int, double, double>* child_Z = &*subnode.Tn_tables.at(mon_Z).at(0).first;
+    EXPECT_EQ(parent_Z, child_Z);
+
+    // the projected table stays valid after its subproblem's arena is dropped
+    Shared<Table<int, double, double>> table_X = subnode.Tn_tables.at(Monotonicity<int, double, double>{X, NULL_ATTR<int, double, double>}).at(0).first;
+    initial_subproblem.reset();
+    subnode.arena.reset();
+    EXPECT_EQ(table_X->data.size(), 4);
+    EXPECT_EQ(table_X->attributes, X);
+}
+
 // Case 3: XY|0 in D and Y;Z|X in S
 TEST(GenerateSubproblemSubnodesTest, Case3_PartitionSubmodularity) {
     attr_type<int, double, double> X = std::bitset<3>("001");
@@ -424,7 +480,7 @@ TEST(GenerateSubproblemSubnodesTest, Case3_PartitionSubmodularity) {
     Monotonicity<int, double, double> mon_XY = {X ^ Y, NULL_ATTR<int, double, double>};
     Submodularity<int, double, double> sub_YZ_X = {Y, Z, X};
     
-    std::unordered_set<HashableRow<int, double, double>> data_XY;
+    RowSet<int, double, double> data_XY;
     for (std::size_t i = 0; i < 2; i++) {
         for (std::size_t j = 0; j < 3; j++) {
             std::array<std::any, 3> row = {
@@ -443,7 +499,7 @@ TEST(GenerateSubproblemSubnodesTest, Case3_PartitionSubmodularity) {
     std::unordered_map<Submodularity<int, double, double>, unsigned> S = {
         {sub_YZ_X, 1}
     };
-    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Table<int, double, double>, Constraint>>> Tn_tables = {
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
         {mon_XY, {{table_XY, 4.0}}}
     };
     Subproblem<int, double, double> initial_subproblem(
@@ -480,3 +536,558 @@ TEST(GenerateSubproblemSubnodesTest, Case3_PartitionSubmodularity) {
         );
     }
 } 
+
+// XY|0 with Y;Z|X and output X - every partition of XY is a leaf
+Subproblem<int, double, double> create_partition_query(std::size_t num_x) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_XY = {X ^ Y, NULL_ATTR<int, double, double>};
+    Submodularity<int, double, double> sub_YZ_X = {Y, Z, X};
+
+    // skewed degrees so the table splits into several partitions
+    RowSet<int, double, double> data_XY;
+    for (std::size_t i = 0; i < num_x; i++) {
+        for (std::size_t j = 0; j <= i; j++) {
+            std::array<std::any, 3> row = {
+                std::any((int) i),
+                std::any((double) j),
+                std::any()
+            };
+            data_XY.insert(create_row<int, double, double>(row));
+        }
+    }
+    Table<int, double, double> table_XY{data_XY, X ^ Y};
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
+        {mon_XY, {{table_XY, (Constraint) data_XY.size()}}}
+    };
+    return Subproblem<int, double, double>(
+        {{X, 1}},
+        {{mon_XY, 1}},
+        Tn_tables,
+        {},
+        {},
+        {{sub_YZ_X, 1}},
+        (long double) data_XY.size()
+    );
+}
+
+TEST(GenerateDdrFeasibleOutputTest, ParallelMatchesSequential) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+
+    FeasibleOutput<int, double, double> sequential = generate_ddr_feasible_output(subproblem);
+    PandaOptions options;
+    options.num_threads = 4;
+    FeasibleOutput<int, double, double> parallel = generate_ddr_feasible_output(subproblem, options);
+
+    ASSERT_EQ(sequential.size(), 1);
+    ASSERT_EQ(parallel.size(), 1);
+    EXPECT_EQ(sequential.at(mon_X).data.size(), 16);
+    EXPECT_EQ(sequential.at(mon_X).data, parallel.at(mon_X).data);
+    // the leaves of the parallel expansion were merged into shards
+    EXPECT_EQ(sequential.at(mon_X).data.shard_count(), 1);
+    EXPECT_GT(parallel.at(mon_X).data.shard_count(), 1);
+}
+
+TEST(GenerateDdrFeasibleOutputTest, ParallelRootStepMatchesSequential) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    // enough rows for the root partition to run the parallel operators
+    Subproblem<int, double, double> subproblem = create_partition_query(400);
+    ASSERT_GE(subproblem.Tn_tables.at({X ^ std::bitset<3>("010"), NULL_ATTR<int, double, double>}).at(0).first->data.size(), PARALLEL_MIN_ROWS);
+
+    WorkStealingPool pool(4);
+    std::vector<Subproblem<int, double, double>> sequential_children = generate_subproblem_subnodes(subproblem);
+    std::vector<Subproblem<int, double, double>> parallel_children = generate_subproblem_subnodes(subproblem, subproblem, PandaOptions(), &pool);
+    ASSERT_EQ(sequential_children.size(), parallel_children.size());
+    auto partition_sizes = [&](const std::vector<Subproblem<int, double, double>>& children) {
+        std::vector<std::size_t> sizes;
+        for (const auto& child : children) {
+            sizes.push_back(child.Tn_tables.at(mon_X).at(0).first->data.size());
+        }
+        std::sort(sizes.begin(), sizes.end());
+        return sizes;
+    };
+    EXPECT_EQ(partition_sizes(sequential_children), partition_sizes(parallel_children));
+
+    FeasibleOutput<int, double, double> sequential = generate_ddr_feasible_output(subproblem);
+    PandaOptions options;
+    options.num_threads = 4;
+    FeasibleOutput<int, double, double> parallel = generate_ddr_feasible_output(subproblem, options);
+    EXPECT_EQ(sequential.at(mon_X).data.size(), 400);
+    EXPECT_EQ(sequential.at(mon_X).data, parallel.at(mon_X).data);
+
+    // every step of a plan runs on the calling thread, so each one can use the pool
+    PlanCache<int, double, double> cache;
+    FeasibleOutput<int, double, double> executed = generate_ddr_feasible_output(*cache.get(subproblem.symbolic_state()), subproblem,
+        PartitionStrategy(), &pool);
+    EXPECT_EQ(sequential.at(mon_X).data, executed.at(mon_X).data);
+}
+
+TEST(GenerateDdrFeasibleOutputTest, DepthFirstMatchesBreadthFirst) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+
+    FeasibleOutput<int, double, double> breadth_first = generate_ddr_feasible_output(subproblem);
+    PandaOptions options;
+    options.order = ExpansionOrder::DEPTH_FIRST;
+    FeasibleOutput<int, double, double> depth_first = generate_ddr_feasible_output(subproblem, options);
+
+    ASSERT_EQ(depth_first.size(), 1);
+    EXPECT_EQ(breadth_first.at(mon_X).data, depth_first.at(mon_X).data);
+}
+
+TEST(StreamDdrFeasibleOutputTest, EmitsLeafTables) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+    FeasibleOutput<int, double, double> expected = generate_ddr_feasible_output(subproblem);
+
+    for (bool deduplicate : {false, true}) {
+        PandaOptions options;
+        options.order = ExpansionOrder::DEPTH_FIRST;
+        options.deduplicate = deduplicate;
+        std::size_t batches = 0;
+        std::size_t emitted_rows = 0;
+        RowSet<int, double, double> streamed;
+        stream_ddr_feasible_output<int, double, double>(subproblem,
+            [&](const OutputAttributes<int, double, double>& output_attrs, const Table<int, double, double>& batch) {
+                EXPECT_EQ(output_attrs, X);
+                batches++;
+                emitted_rows += batch.data.size();
+                streamed.insert(batch.data.begin(), batch.data.end());
+            },
+            options);
+        EXPECT_GT(batches, 1);
+        EXPECT_EQ(expected.at(mon_X).data, (ShardedRowSet<int, double, double>(streamed)));
+        if (deduplicate) {
+            EXPECT_EQ(emitted_rows, streamed.size());
+        }
+    }
+}
+
+TEST(PlanTest, CompiledPlanMatchesInterpreter) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+
+    PlanCache<int, double, double> cache;
+    std::shared_ptr<const Plan<int, double, double>> plan = cache.get(subproblem.symbolic_state());
+    EXPECT_EQ(plan->root->step, PlanStep::PARTITION);
+    EXPECT_TRUE(plan->root->data_dependent());
+    EXPECT_EQ(plan->root->next->step, PlanStep::LEAF);
+    EXPECT_EQ(plan->size, 2);
+
+    // a fresh snapshot of the same query shape reuses the plan
+    Subproblem<int, double, double> snapshot = create_partition_query(24);
+    EXPECT_EQ(cache.get(snapshot.symbolic_state()), plan);
+    EXPECT_EQ(cache.size(), 1);
+
+    for (const auto& query : {subproblem, snapshot}) {
+        FeasibleOutput<int, double, double> interpreted = generate_ddr_feasible_output(query);
+        FeasibleOutput<int, double, double> executed = generate_ddr_feasible_output(*plan, query);
+        ASSERT_EQ(executed.size(), 1);
+        EXPECT_EQ(interpreted.at(mon_X).data, executed.at(mon_X).data);
+    }
+}
+
+TEST(SubproblemMemoTest, EquivalentContentHits) {
+    Subproblem<int, double, double> subproblem = create_partition_query(8);
+    // same contents behind different handles
+    Subproblem<int, double, double> equivalent = create_partition_query(8);
+    Subproblem<int, double, double> different = create_partition_query(9);
+
+    EXPECT_EQ(subproblem_fingerprint(subproblem), subproblem_fingerprint(equivalent));
+    EXPECT_TRUE(equivalent_subproblems(subproblem, equivalent));
+    EXPECT_FALSE(equivalent_subproblems(subproblem, different));
+
+    SubproblemMemo<int, double, double> memo;
+    memo.insert(subproblem, subproblem_fingerprint(subproblem), {});
+    EXPECT_NE(memo.find(equivalent, subproblem_fingerprint(equivalent)), nullptr);
+    EXPECT_EQ(memo.find(different, subproblem_fingerprint(different)), nullptr);
+    EXPECT_EQ(memo.hits(), 1);
+}
+
+// AB|0 partitioned with B;C|A, then each A_i|0 conditioned on C|A over the bound - the reset lemma removes AC|0
+// with the partition's B|AC (leaving ABC out of Z), so every partition continues with the same BC|0, split
+// on B for the output B
+Subproblem<int, double, double> create_equivalent_subtrees_query(std::size_t num_a) {
+    attr_type<int, double, double> A = std::bitset<3>("001");
+    attr_type<int, double, double> B = std::bitset<3>("010");
+    attr_type<int, double, double> C = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_AB = {A ^ B, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_BC = {B ^ C, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_C_A = {C, A};
+    Monotonicity<int, double, double> mon_C_B = {C, B};
+    Submodularity<int, double, double> sub_BC_A = {B, C, A};
+
+    // skewed degrees so AB splits into several partitions
+    Table<int, double, double> table_AB{RowSet<int, double, double>(), A ^ B};
+    Table<int, double, double> table_AC{RowSet<int, double, double>(), A ^ C};
+    for (std::size_t i = 0; i < num_a; i++) {
+        for (std::size_t j = 0; j <= i; j++) {
+            std::array<std::any, 3> row_AB = {std::any((int) i), std::any((double) j), std::any()};
+            table_AB.data.insert(create_row<int, double, double>(row_AB));
+        }
+        std::array<std::any, 3> row_AC = {std::any((int) i), std::any(), std::any((double) i)};
+        table_AC.data.insert(create_row<int, double, double>(row_AC));
+    }
+    // large enough that partitioning AB is cheaper than splitting BC
+    Table<int, double, double> table_BC{RowSet<int, double, double>(), B ^ C};
+    for (std::size_t k = 0; k < 32 * num_a * num_a; k++) {
+        std::array<std::any, 3> row_BC = {std::any(), std::any((double) (k % 64)), std::any((double) k)};
+        table_BC.data.insert(create_row<int, double, double>(row_BC));
+    }
+    Dictionary<int, double, double> dict_C_A = construction(table_AC, A, C);
+
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
+        {mon_AB, {{table_AB, (Constraint) table_AB.data.size()}}},
+        {mon_BC, {{table_BC, (Constraint) table_BC.data.size()}}}
+    };
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Dictionary<int, double, double>>, Constraint>>> Tn_dicts = {
+        {mon_C_A, {{dict_C_A, (Constraint) table_BC.data.size()}}}
+    };
+    return Subproblem<int, double, double>(
+        {{A ^ B ^ C, 1}, {B, 1}},
+        {{mon_AB, 1}, {mon_BC, 1}, {mon_C_A, 1}},
+        Tn_tables,
+        Tn_dicts,
+        {{mon_C_B, 1}},
+        {{sub_BC_A, 1}},
+        (long double) table_AB.data.size()
+    );
+}
+
+TEST(GenerateDdrFeasibleOutputTest, MemoizedMatchesUnmemoized) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+
+    FeasibleOutput<int, double, double> unmemoized = generate_ddr_feasible_output(subproblem);
+    PandaOptions options;
+    options.memoize = true;
+    FeasibleOutput<int, double, double> memoized = generate_ddr_feasible_output(subproblem, options);
+    ASSERT_EQ(memoized.size(), 1);
+    EXPECT_EQ(unmemoized.at(mon_X).data, memoized.at(mon_X).data);
+}
+
+TEST(GenerateDdrFeasibleOutputTest, MemoizedEquivalentSubtrees) {
+    attr_type<int, double, double> B = std::bitset<3>("010");
+    Monotonicity<int, double, double> mon_B = {B, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_equivalent_subtrees_query(8);
+
+    std::vector<std::pair<CaseChoice<int, double, double>, long double>> ranked = rank_cases(subproblem);
+    ASSERT_FALSE(ranked.empty());
+    EXPECT_EQ(ranked[0].first.type, CaseType::PARTITION);
+    std::vector<Subproblem<int, double, double>> partitions = generate_subproblem_subnodes(subproblem);
+    ASSERT_GT(partitions.size(), 1);
+
+    // the subtree after each partition's condition step is expanded once and reused by every other partition
+    SubproblemMemo<int, double, double> memo;
+    PandaOptions options;
+    options.memoize = true;
+    Table<int, double, double> memoized{RowSet<int, double, double>(), B};
+    std::size_t outputs = 0;
+    auto on_output = [&](const Monotonicity<int, double, double>& monotonicity, const Shared<Table<int, double, double>>& table) {
+        EXPECT_EQ(monotonicity, mon_B);
+        outputs++;
+        inplace_union(memoized, *table);
+    };
+    visit_subproblem_outputs_memoized(subproblem, subproblem, memo, on_output, options);
+    EXPECT_GT(memo.hits(), 0);
+    EXPECT_EQ(memo.hits(), partitions.size() - 1);
+    EXPECT_EQ(outputs, partitions.size());
+
+    FeasibleOutput<int, double, double> unmemoized = generate_ddr_feasible_output(subproblem);
+    ASSERT_EQ(unmemoized.size(), 1);
+    EXPECT_EQ(unmemoized.at(mon_B).data.size(), 64);
+    EXPECT_EQ(unmemoized.at(mon_B).data, (ShardedRowSet<int, double, double>(memoized.data)));
+    EXPECT_EQ(generate_ddr_feasible_output(subproblem, options).at(mon_B).data, unmemoized.at(mon_B).data);
+}
+
+// the partition query with a second path to X - XZ|0 and Z|X, where XZ holds the same X values as XY
+Subproblem<int, double, double> create_split_or_partition_query(std::size_t num_x) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_XZ = {X ^ Z, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_Z_X = {Z, X};
+    Subproblem<int, double, double> partition_query = create_partition_query(num_x);
+
+    RowSet<int, double, double> data_XZ;
+    for (std::size_t i = 0; i < num_x; i++) {
+        std::array<std::any, 3> row = {std::any((int) i), std::any(), std::any((double) i)};
+        data_XZ.insert(create_row<int, double, double>(row));
+    }
+    auto Tn_tables = partition_query.Tn_tables;
+    Tn_tables[mon_XZ].push_back({Table<int, double, double>{data_XZ, X ^ Z}, (Constraint) num_x});
+    std::unordered_map<Monotonicity<int, double, double>, unsigned> D = {{mon_XZ, 1}};
+    for (const auto& monotonicity : partition_query.D.by_X(NULL_ATTR<int, double, double>)) {
+        D[monotonicity] = 1;
+    }
+    return Subproblem<int, double, double>(partition_query.Z, D, Tn_tables, {}, {{mon_Z_X, 1}},
+        partition_query.S, partition_query.global_bound);
+}
+
+TEST(CaseSelectionTest, CheapestCaseFirst) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_XZ = {X ^ Z, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_split_or_partition_query(16);
+
+    // splitting the small XZ is cheaper than partitioning XY
+    std::vector<std::pair<CaseChoice<int, double, double>, long double>> ranked = rank_cases(subproblem);
+    ASSERT_EQ(ranked.size(), 2);
+    EXPECT_EQ(ranked[0].first.type, CaseType::SPLIT);
+    EXPECT_EQ(ranked[0].first.monotonicity, mon_XZ);
+    EXPECT_EQ(ranked[1].first.type, CaseType::PARTITION);
+    EXPECT_LT(ranked[0].second, ranked[1].second);
+
+    std::vector<Subproblem<int, double, double>> subnodes = generate_subproblem_subnodes(subproblem);
+    ASSERT_EQ(subnodes.size(), 1);
+    EXPECT_EQ(subnodes[0].D.count(mon_X), 1);
+    EXPECT_EQ(subnodes[0].D.count(mon_XZ), 0);
+
+    PandaOptions first_match;
+    first_match.selection = CaseSelection::FIRST_MATCH;
+    FeasibleOutput<int, double, double> expected = generate_ddr_feasible_output(subproblem, first_match);
+    for (CaseSelection selection : {CaseSelection::CHEAPEST, CaseSelection::BEAM}) {
+        PandaOptions options;
+        options.selection = selection;
+        FeasibleOutput<int, double, double> feasible_output = generate_ddr_feasible_output(subproblem, options);
+        ASSERT_EQ(feasible_output.size(), 1);
+        EXPECT_EQ(expected.at(mon_X).data, feasible_output.at(mon_X).data);
+    }
+}
+
+TEST(CaseSelectionTest, SameCaseAsFirstMatch) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    Monotonicity<int, double, double> mon_Y_X = {Y, X};
+    Subproblem<int, double, double> partition_query = create_partition_query(16);
+    // XY can be split on X as well as partitioned - choose_case splits it, so partitioning is never ranked
+    Subproblem<int, double, double> subproblem(partition_query.Z, partition_query.D, partition_query.Tn_tables, {},
+        {{mon_Y_X, 1}}, partition_query.S, partition_query.global_bound);
+
+    std::vector<std::pair<CaseChoice<int, double, double>, long double>> ranked = rank_cases(subproblem);
+    ASSERT_EQ(ranked.size(), 1);
+    EXPECT_EQ(ranked[0].first.type, CaseType::SPLIT);
+    EXPECT_EQ(choose_case(subproblem).type, CaseType::SPLIT);
+}
+
+TEST(CaseSelectionTest, BeamScoresLeavesOfOriginal) {
+    attr_type<int, double, double> A = std::bitset<3>("001");
+    attr_type<int, double, double> B = std::bitset<3>("010");
+    attr_type<int, double, double> C = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_A = {A, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_B_A = {B, A};
+    Monotonicity<int, double, double> mon_AB = {A ^ B, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_ABC = {A ^ B ^ C, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_BC = {B ^ C, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_C_AB = {C, A ^ B};
+    Monotonicity<int, double, double> mon_C_B = {C, B};
+
+    Table<int, double, double> table_ABC{RowSet<int, double, double>(), A ^ B ^ C};
+    for (int i = 0; i < 4; i++) {
+        std::array<std::any, 3> row = {std::any(i), std::any((double) i), std::any((double) i)};
+        table_ABC.data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> table_BC{RowSet<int, double, double>(), B ^ C};
+    for (int i = 0; i < 16; i++) {
+        std::array<std::any, 3> row = {std::any(), std::any((double) (i % 4)), std::any((double) i)};
+        table_BC.data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> table_AB = project(table_ABC, A ^ B);
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
+        {mon_A, {{project(table_ABC, A), 4.0}}},
+        {mon_ABC, {{table_ABC, 4.0}}},
+        {mon_BC, {{table_BC, 16.0}}}
+    };
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Dictionary<int, double, double>>, Constraint>>> Tn_dicts = {
+        {mon_B_A, {{construction(table_AB, A, B), 4.0}}}
+    };
+    // A|0 and B|A join over the bound, and Case 0 of the reset lemma removes AB from Z
+    Subproblem<int, double, double> subproblem({{A ^ B, 1}, {B, 1}}, {{mon_A, 1}, {mon_B_A, 1}, {mon_ABC, 1}, {mon_BC, 1}},
+        Tn_tables, Tn_dicts, {{mon_C_AB, 1}, {mon_C_B, 1}}, {}, 8.0);
+    std::vector<Subproblem<int, double, double>> reset = generate_subproblem_subnodes(subproblem);
+    ASSERT_EQ(reset.size(), 1);
+    EXPECT_EQ(reset[0].Z.count(A ^ B), 0);
+    EXPECT_EQ(reset[0].D.count(mon_A), 0);
+
+    // splitting ABC is cheaper and its child AB|0 is a leaf of the original - a score against the reduced Z would
+    // add the BC split to it and pick splitting BC instead
+    PandaOptions options;
+    options.selection = CaseSelection::BEAM;
+    std::vector<std::pair<CaseChoice<int, double, double>, long double>> ranked = rank_cases(reset[0]);
+    ASSERT_EQ(ranked.size(), 2);
+    EXPECT_EQ(ranked[0].first.monotonicity, mon_ABC);
+    std::vector<Subproblem<int, double, double>> beam = generate_subproblem_subnodes(subproblem, reset[0], options);
+    ASSERT_EQ(beam.size(), 1);
+    EXPECT_EQ(beam[0].D.count(mon_AB), 1);
+    EXPECT_EQ(beam[0].D.count(mon_ABC), 0);
+
+    FeasibleOutput<int, double, double> feasible_output = generate_ddr_feasible_output(subproblem, options);
+    ASSERT_EQ(feasible_output.size(), 1);
+    EXPECT_EQ(feasible_output.at(mon_AB).data, (ShardedRowSet<int, double, double>(table_AB.data)));
+}
+
+TEST(CaseSelectionTest, InfeasibleConditionSkipped) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_Y_X = {Y, X};
+    Monotonicity<int, double, double> mon_XZ = {X ^ Z, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_X_Z = {X, Z};
+    Monotonicity<int, double, double> mon_Z = {Z, NULL_ATTR<int, double, double>};
+
+    Table<int, double, double> table_XY{RowSet<int, double, double>(), X ^ Y};
+    Table<int, double, double> table_XZ{RowSet<int, double, double>(), X ^ Z};
+    for (int i = 0; i < 4; i++) {
+        std::array<std::any, 3> row_XY = {std::any(i), std::any((double) i), std::any()};
+        table_XY.data.insert(create_row<int, double, double>(row_XY));
+        std::array<std::any, 3> row_XZ = {std::any(i), std::any(), std::any((double) i)};
+        table_XZ.data.insert(create_row<int, double, double>(row_XZ));
+    }
+    Table<int, double, double> table_X = project(table_XY, X);
+    Dictionary<int, double, double> dict_Y_X = construction(table_XY, X, Y);
+
+    // X|0 and Y|X join over the bound, and nothing removes XY|0 afterwards - only XZ|0 split on Z leads to Z
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Table<int, double, double>>, Constraint>>> Tn_tables = {
+        {mon_X, {{table_X, 4.0}}},
+        {mon_XZ, {{table_XZ, 4.0}}}
+    };
+    std::unordered_map<Monotonicity<int, double, double>, std::vector<std::pair<Shared<Dictionary<int, double, double>>, Constraint>>> Tn_dicts = {
+        {mon_Y_X, {{dict_Y_X, 4.0}}}
+    };
+    Subproblem<int, double, double> subproblem({{Z, 1}}, {{mon_X, 1}, {mon_Y_X, 1}, {mon_XZ, 1}}, Tn_tables, Tn_dicts,
+        {{mon_X_Z, 1}}, {}, 8.0);
+
+    CaseChoice<int, double, double> condition{CaseType::CONDITION, mon_X, mon_Y_X, {}};
+    EXPECT_FALSE(case_feasible(subproblem, condition));
+    std::vector<std::pair<CaseChoice<int, double, double>, long double>> ranked = rank_cases(subproblem);
+    ASSERT_EQ(ranked.size(), 1);
+    EXPECT_EQ(ranked[0].first.type, CaseType::SPLIT);
+
+    for (CaseSelection selection : {CaseSelection::CHEAPEST, CaseSelection::BEAM}) {
+        PandaOptions options;
+        options.selection = selection;
+        FeasibleOutput<int, double, double> feasible_output = generate_ddr_feasible_output(subproblem, options);
+        ASSERT_EQ(feasible_output.size(), 1);
+        EXPECT_EQ(feasible_output.at(mon_Z).data.size(), 4);
+    }
+
+    // with no feasible case left the condition's error propagates
+    Subproblem<int, double, double> stuck({{Z, 1}}, {{mon_X, 1}, {mon_Y_X, 1}}, {{mon_X, {{table_X, 4.0}}}}, Tn_dicts,
+        {}, {}, 8.0);
+    EXPECT_TRUE(rank_cases(stuck).empty());
+    EXPECT_THROW(generate_subproblem_subnodes(stuck), std::runtime_error);
+}
+
+TEST(GenerateDdrFeasibleOutputTest, PartitionStrategiesMatch) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    Monotonicity<int, double, double> mon_X = {X, NULL_ATTR<int, double, double>};
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+    FeasibleOutput<int, double, double> expected = generate_ddr_feasible_output(subproblem);
+
+    PandaOptions heavy_light;
+    heavy_light.partition_strategy.mode = PartitionMode::HEAVY_LIGHT;
+    PandaOptions coalesced;
+    coalesced.partition_strategy.coalesce_rows = 32;
+    coalesced.partition_strategy.split_classes = false;
+    for (const auto& options : {heavy_light, coalesced}) {
+        FeasibleOutput<int, double, double> feasible_output = generate_ddr_feasible_output(subproblem, options);
+        ASSERT_EQ(feasible_output.size(), 1);
+        EXPECT_EQ(expected.at(mon_X).data, feasible_output.at(mon_X).data);
+    }
+}
+
+Table<int, double, double> leaf_test_table(int first, int last, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    Table<int, double, double> table{RowSet<int, double, double>(resource), std::bitset<3>("001")};
+    for (int value = first; value < last; value++) {
+        std::array<std::any, 3> row = {std::any(value), std::any(), std::any()};
+        table.data.insert(create_row<int, double, double>(row));
+    }
+    return table;
+}
+
+TEST(OutputUnionTest, MovesUnsharedTables) {
+    auto arena = std::make_shared<SubproblemArena>();
+    Shared<Table<int, double, double>> heap_table(leaf_test_table(0, 100));
+    Shared<Table<int, double, double>> arena_table(leaf_test_table(50, 120, &arena->resource), arena);
+    const HashableRow<int, double, double>* heap_row = &*heap_table->data.begin();
+    ShardedRowSet<int, double, double> expected(leaf_test_table(0, 120).data);
+
+    // a table referenced elsewhere is copied, and left intact
+    OutputUnion<int, double, double> copied(heap_table->attributes, 0);
+    Shared<Table<int, double, double>> kept = heap_table;
+    copied.add(heap_table);
+    copied.add(arena_table);
+    ShardedTable<int, double, double> copied_table = copied.take();
+    EXPECT_EQ(copied_table.data, expected);
+    EXPECT_EQ(kept->data.size(), 100);
+    EXPECT_NE(&*copied_table.data.shard(0).find(*heap_row), heap_row);
+
+    // the last handle to a heap table is moved in whole
+    OutputUnion<int, double, double> moved(heap_table->attributes, 0);
+    kept = arena_table;
+    moved.add(std::move(heap_table));
+    ShardedTable<int, double, double> moved_table = moved.take();
+    EXPECT_EQ(&*moved_table.data.shard(0).find(*heap_row), heap_row);
+
+    // and the arena table is copied into it
+    OutputUnion<int, double, double> merged(kept->attributes, 0);
+    merged.add(Shared<Table<int, double, double>>(leaf_test_table(0, 100)));
+    merged.add(std::move(arena_table));
+    EXPECT_EQ(merged.take().data, expected);
+    EXPECT_EQ(kept->data.size(), 70);
+}
+
+TEST(OutputUnionTest, LeafTablesReleased) {
+    // the output tables of the leaves are on the heap, and their handles are the last ones (the memo only keeps
+    // the leaves a memoized subproblem can replay, and no partition here is below another)
+    Subproblem<int, double, double> subproblem = create_partition_query(16);
+    for (bool memoize : {false, true}) {
+        PandaOptions options;
+        options.memoize = memoize;
+        std::size_t leaves = 0;
+        std::size_t released = 0;
+        visit_leaf_tables(subproblem, nullptr,
+            [&](const Monotonicity<int, double, double>&, Shared<Table<int, double, double>> table) {
+                leaves++;
+                released += table.release().has_value();
+            },
+            options);
+        EXPECT_GT(leaves, 1);
+        EXPECT_EQ(released, leaves);
+    }
+}
+
+TEST(OutputUnionTest, ConcurrentAddsMatchSequential) {
+    WorkStealingPool pool(4);
+    int block = 1000;
+    std::vector<Shared<Table<int, double, double>>> tables;
+    for (int i = 0; i < 16; i++) {
+        tables.emplace_back(leaf_test_table(i * block, (i + 2) * block));
+    }
+    OutputUnion<int, double, double> sequential(tables[0]->attributes, 0);
+    OutputUnion<int, double, double> sharded(tables[0]->attributes, shard_bits(pool));
+    for (const auto& table : tables) {
+        sequential.add(table);
+        pool.submit([&sharded, table](std::size_t) { sharded.add(table); });
+    }
+    pool.wait();
+
+    ShardedTable<int, double, double> sequential_table = sequential.take();
+    ShardedTable<int, double, double> sharded_table = sharded.take();
+    EXPECT_EQ(sequential_table.data.size(), 17 * block);
+    EXPECT_EQ(sharded_table.data, sequential_table.data);
+    for (std::size_t shard = 0; shard < sharded_table.data.shard_count(); shard++) {
+        for (const auto& row : sharded_table.data.shard(shard)) {
+            EXPECT_EQ(sharded_table.data.shard_of(row.hash), shard);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <any>
+#include <array>
+#include <bitset>
+
+#include "src/model/parallel_table.h"
+#include "src/model/table.h"
+#include "src/thread_pool.h"
+#include "tst/test_utils.h"
+
+using ParallelRow = HashableRow<int, int, double>;
+using ParallelTable = Table<int, int, double>;
+using ParallelRows = ShardedRowSet<int, int, double>;
+
+// enough rows for several morsels, with skewed X degrees and a projection that collapses rows
+ParallelTable parallel_test_table() {
+    ParallelTable table{RowSet<int, int, double>(), std::bitset<3>("111")};
+    for (std::size_t i = 0; i < PARALLEL_MIN_ROWS + 3 * MORSEL_SIZE; i++) {
+        int x = i % 1000 < 10 ? (int) (i % 10) : (int) (i % 5000);
+        std::array<std::any, 3> row = {std::any(x), std::any((int) (i % 7)), std::any((double) i)};
+        table.data.insert(create_row<int, int, double>(row));
+    }
+    return table;
+}
+
+TEST(ParallelTableTest, OperatorsMatchSequential) {
+    WorkStealingPool pool(4);
+    ParallelTable table = parallel_test_table();
+
+    ShardedTable<int, int, double> proj_table = parallel_project(pool, table, std::bitset<3>("011"));
+    EXPECT_EQ(proj_table.data, ParallelRows(project(table, std::bitset<3>("011")).data));
+    // the merged shards are the output - every row is in its hash's shard
+    ASSERT_EQ(proj_table.data.shard_bits(), shard_bits(pool));
+    for (std::size_t shard = 0; shard < proj_table.data.shard_count(); shard++) {
+        for (const ParallelRow& row : proj_table.data.shard(shard)) {
+            EXPECT_EQ(proj_table.data.shard_of(row.hash), shard);
+        }
+    }
+
+    Dictionary<int, int, double> dict = construction(table, std::bitset<3>("001"), std::bitset<3>("110"));
+    Dictionary<int, int, double> parallel_dict = parallel_construction(pool, table, std::bitset<3>("001"), std::bitset<3>("110"));
+    EXPECT_TRUE(same_content(parallel_dict, dict));
+
+    // Y rows are deduplicated per key when the table has attributes outside XY
+    Dictionary<int, int, double> dedup_dict = construction(table, std::bitset<3>("001"), std::bitset<3>("010"));
+    EXPECT_TRUE(same_content(parallel_construction(pool, table, std::bitset<3>("001"), std::bitset<3>("010")), dedup_dict));
+
+    ParallelTable probe = project(table, std::bitset<3>("011"));
+    EXPECT_EQ(parallel_join(pool, probe, dict).data, ParallelRows(join(probe, dict).data));
+    Dictionary<int, int, double> extended = extension(dedup_dict, std::bitset<3>("100"));
+    EXPECT_EQ(parallel_join(pool, table, extended).data, ParallelRows(join(table, extended).data));
+
+    // sharded outputs feed the next operator directly
+    EXPECT_EQ(parallel_join(pool, proj_table, dict).data, ParallelRows(join(probe, dict).data));
+}
+
+TEST(ParallelTableTest, PartitionMatchesSequential) {
+    WorkStealingPool pool(4);
+    ParallelTable table = parallel_test_table();
+    for (PartitionMode mode : {PartitionMode::LOG_DEGREE, PartitionMode::HEAVY_LIGHT}) {
+        PartitionStrategy strategy;
+        strategy.mode = mode;
+        std::vector<ParallelTable> parallel_partitions = parallel_partition(pool, table, std::bitset<3>("001"), strategy);
+        std::vector<ParallelTable> partitions = partition(table, std::bitset<3>("001"), strategy);
+
+        // same number of tables with the same rows in total - the tables of a class may differ in which X values
+        // they hold, since the runs are grouped in a different order
+        ASSERT_EQ(parallel_partitions.size(), partitions.size());
+        ParallelTable parallel_union{RowSet<int, int, double>(), table.attributes};
+        for (const auto& partitioned_table : parallel_partitions) {
+            inplace_union(parallel_union, partitioned_table);
+        }
+        EXPECT_EQ(parallel_union.data, table.data);
+    }
+}
+
+TEST(ParallelTableTest, InplaceUnionMatchesSequential) {
+    WorkStealingPool pool(4);
+    ParallelTable table = parallel_test_table();
+    ParallelTable half{RowSet<int, int, double>(), table.attributes};
+    for (const ParallelRow& row : table.data) {
+        if (row.get<1>() % 2 == 0) {
+            half.data.insert(row);
+        }
+    }
+
+    // a single shard is resharded before the union
+    ShardedTable<int, int, double> union_table{ParallelRows(half.data), table.attributes};
+    parallel_inplace_union(pool, union_table, table);
+    EXPECT_EQ(union_table.data.shard_bits(), shard_bits(pool));
+    EXPECT_EQ(union_table.data, ParallelRows(table.data));
+    parallel_inplace_union(pool, union_table, half);
+    EXPECT_EQ(union_table.data, ParallelRows(table.data));
+
+    // small inputs fall back to the sequential union
+    ShardedTable<int, int, double> small{ParallelRows(), table.attributes};
+    ParallelTable added{RowSet<int, int, double>(), table.attributes};
+    added.data.insert(*table.data.begin());
+    parallel_inplace_union(pool, small, added);
+    EXPECT_EQ(small.data, ParallelRows(added.data));
+}
+
+TEST(ParallelTableTest, ConcurrentOutputsMatchSequential) {
+    WorkStealingPool pool(4);
+    ParallelTable table = parallel_test_table();
+    auto to_table = [](const ConcurrentTable<int, int, double>& concurrent_table) {
+        ParallelTable copied{RowSet<int, int, double>(), concurrent_table.attributes};
+        inplace_union(copied, concurrent_table);
+        return copied;
+    };
+
+    ConcurrentTable<int, int, double> proj_table{ConcurrentRowSet<int, int, double>(), {}};
+    parallel_project(pool, table, std::bitset<3>("011"), proj_table);
+    ParallelTable expected_proj = project(table, std::bitset<3>("011"));
+    EXPECT_EQ(proj_table.attributes, expected_proj.attributes);
+    EXPECT_EQ(to_table(proj_table).data, expected_proj.data);
+
+    Dictionary<int, int, double> dict = construction(table, std::bitset<3>("001"), std::bitset<3>("110"));
+    ConcurrentTable<int, int, double> join_table{ConcurrentRowSet<int, int, double>(), {}};
+    parallel_join(pool, expected_proj, dict, join_table);
+    EXPECT_EQ(to_table(join_table).data, join(expected_proj, dict).data);
+
+    ConcurrentTable<int, int, double> union_table{ConcurrentRowSet<int, int, double>(), table.attributes};
+    parallel_inplace_union(pool, union_table, table);
+    parallel_inplace_union(pool, union_table, table);
+    EXPECT_EQ(to_table(union_table).data, table.data);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <bitset>
+#include <string>
+#include <tuple>
+
+#include "src/model/packed_key.h"
+#include "src/model/row.h"
+#include "tst/test_utils.h"
+
+// schema-specific hash policy selection
+template<>
+struct row_hash_policy<short, long> {
+    using type = StdHashPolicy;
+};
+
+TEST(RowTest, AbsentColumnsIgnoredTest) {
+    HashableRow<int, double, std::string> row1({1, 2.0, "a"}, std::bitset<3>("011"));
+    HashableRow<int, double, std::string> row2({1, 2.0, "b"}, std::bitset<3>("011"));
+    HashableRow<int, double, std::string> row3({1, 2.0, "a"}, std::bitset<3>("111"));
+    EXPECT_EQ(row1, row2);
+    EXPECT_EQ(row1.hash, row2.hash);
+    EXPECT_FALSE(row1 == row3);
+}
+
+TEST(RowTest, MaskRowTest) {
+    HashableRow<int, double, std::string> row({1, 2.0, "a"}, std::bitset<3>("111"));
+    HashableRow<int, double, std::string> masked = mask_row(std::bitset<3>("101"), row);
+    EXPECT_EQ(masked.attributes, std::bitset<3>("101"));
+    EXPECT_EQ(masked.get<0>(), 1);
+    EXPECT_EQ(masked.get<2>(), "a");
+    EXPECT_FALSE(masked.has_value<1>());
+    std::array<std::any, 3> expected = {std::any(1), std::any(), std::any(std::string("a"))};
+    auto expected_row = create_row<int, double, std::string>(expected);
+    EXPECT_EQ(masked, expected_row);
+}
+
+TEST(RowTest, JoinRowsTest) {
+    HashableRow<int, double, std::string> row_X({1, 0.0, ""}, std::bitset<3>("001"));
+    HashableRow<int, double, std::string> row_Y({0, 2.0, "a"}, std::bitset<3>("110"));
+    HashableRow<int, double, std::string> joined = join_rows(row_X, row_Y, std::bitset<3>("001"), std::bitset<3>("110"));
+    HashableRow<int, double, std::string> expected({1, 2.0, "a"}, std::bitset<3>("111"));
+    EXPECT_EQ(joined, expected);
+}
+
+TEST(RowTest, InternedStringTest) {
+    InternedString a1("apple");
+    InternedString a2(std::string("apple"));
+    InternedString b("banana");
+    EXPECT_EQ(a1, a2);
+    EXPECT_NE(a1, b);
+    EXPECT_EQ(a1.str(), "apple");
+    EXPECT_EQ(InternedString().str(), "");
+
+    HashableRow<int, InternedString> row1({1, a1}, std::bitset<2>("11"));
+    HashableRow<int, InternedString> row2({1, a2}, std::bitset<2>("11"));
+    EXPECT_EQ(row1, row2);
+    EXPECT_EQ(row1.hash, row2.hash);
+}
+
+TEST(RowTest, PackedKeyTest) {
+    static_assert(std::is_same_v<key_type<int, double>, PackedKey<int, double>>);
+    static_assert(std::is_same_v<key_type<int, std::string>, HashableRow<int, std::string>>);
+
+    HashableRow<int, double, InternedString> row1({1, 2.0, InternedString("a")}, std::bitset<3>("111"));
+    HashableRow<int, double, InternedString> row2({1, 3.0, InternedString("a")}, std::bitset<3>("111"));
+    HashableRow<int, double, InternedString> row3({2, 2.0, InternedString("a")}, std::bitset<3>("111"));
+    auto attrs = std::bitset<3>("101");
+    PackedKey<int, double, InternedString> key1(attrs, row1);
+    PackedKey<int, double, InternedString> key2(attrs, row2);
+    PackedKey<int, double, InternedString> key3(attrs, row3);
+    EXPECT_EQ(key1.size, sizeof(int) + sizeof(InternedString));
+    EXPECT_EQ(key1, key2);
+    EXPECT_EQ(key1.hash, key2.hash);
+    EXPECT_FALSE(key1 == key3);
+
+    auto unpacked = unpack(key1);
+    auto expected = mask_row(attrs, row1);
+    EXPECT_EQ(unpacked, expected);
+
+    HashableRow<int, double> pos_zero({0, 0.0}, std::bitset<2>("11"));
+    HashableRow<int, double> neg_zero({0, -0.0}, std::bitset<2>("11"));
+    PackedKey<int, double> pos_key(pos_zero);
+    PackedKey<int, double> neg_key(neg_zero);
+    EXPECT_EQ(pos_key, neg_key);
+
+    // keys of up to four columns stay inline whatever the width of the schema, wider keys spill to the heap
+    using WideKey = PackedKey<int64_t, int64_t, int64_t, int64_t, int64_t>;
+    static_assert(WideKey::INLINE_CAPACITY == 4 * sizeof(int64_t));
+    static_assert(WideKey::INLINE_CAPACITY < WideKey::CAPACITY);
+    static_assert(PackedKey<int, double>::INLINE_CAPACITY == PackedKey<int, double>::CAPACITY);
+    static_assert(PackedKey<char, double, int, int64_t, short, double>::INLINE_CAPACITY == 3 * sizeof(double) + sizeof(int));
+    HashableRow<int64_t, int64_t, int64_t, int64_t, int64_t> wide_row({1, 2, 3, 4, 5}, std::bitset<5>("11111"));
+    WideKey narrow_key(std::bitset<5>("00001"), wide_row);
+    WideKey wide_key(wide_row);
+    EXPECT_EQ(narrow_key.size, sizeof(int64_t));
+    EXPECT_EQ(wide_key.size, WideKey::CAPACITY);
+    WideKey four_column_key(std::bitset<5>("01111"), wide_row);
+    EXPECT_EQ(four_column_key.size, WideKey::INLINE_CAPACITY);
+    EXPECT_EQ(unpack(four_column_key), mask_row(std::bitset<5>("01111"), wide_row));
+    WideKey wide_copy = wide_key;
+    WideKey wide_moved = std::move(wide_copy);
+    EXPECT_EQ(wide_moved, wide_key);
+    wide_copy = narrow_key;
+    EXPECT_EQ(wide_copy, narrow_key);
+    EXPECT_EQ(unpack(wide_moved), wide_row);
+    EXPECT_EQ(unpack(narrow_key), mask_row(std::bitset<5>("00001"), wide_row));
+}
+
+TEST(RowTest, CachedColumnHashesTest) {
+    HashableRow<int, double, std::string> row_X({1, 0.0, ""}, std::bitset<3>("001"));
+    HashableRow<int, double, std::string> row_Y({0, 2.0, "a"}, std::bitset<3>("110"));
+    HashableRow<int, double, std::string> joined = join_rows(row_X, row_Y, std::bitset<3>("001"), std::bitset<3>("110"));
+    HashableRow<int, double, std::string> masked = mask_row(std::bitset<3>("100"), joined);
+
+    // rows assembled from cached column hashes hash the same as rows hashed from scratch
+    HashableRow<int, double, std::string> fresh_joined({1, 2.0, "a"}, std::bitset<3>("111"));
+    HashableRow<int, double, std::string> fresh_masked({0, 0.0, "a"}, std::bitset<3>("100"));
+    EXPECT_EQ(joined.column_hashes, fresh_joined.column_hashes);
+    EXPECT_EQ(joined.hash, fresh_joined.hash);
+    EXPECT_EQ(masked.hash, fresh_masked.hash);
+    EXPECT_EQ(masked.column_hashes[0], 0);
+}
+
+TEST(RowTest, HashPolicyTest) {
+    static_assert(std::is_same_v<HashableRow<int, double>::hash_policy, WyHashPolicy>);
+    static_assert(std::is_same_v<HashableRow<short, long>::hash_policy, StdHashPolicy>);
+
+    HashableRow<short, long> row({3, 4}, std::bitset<2>("11"));
+    std::size_t expected = StdHashPolicy::init(2);
+    expected = StdHashPolicy::combine(expected, 0, std::hash<short>{}(3));
+    expected = StdHashPolicy::combine(expected, 1, std::hash<long>{}(4));
+    EXPECT_EQ(row.hash, expected);
+
+    // sequential integers must not map to sequential hashes
+    EXPECT_NE(WyHashPolicy::hash_column(1) + 1, WyHashPolicy::hash_column(2));
+    EXPECT_EQ(WyHashPolicy::hash_column(0.0), WyHashPolicy::hash_column(-0.0));
+}
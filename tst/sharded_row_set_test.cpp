@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <any>
+#include <array>
+#include <bitset>
+#include <thread>
+#include <vector>
+
+#include "src/model/sharded_row_set.h"
+#include "src/model/table.h"
+#include "tst/test_utils.h"
+
+HashableRow<int, int, double> sharded_test_row(int value) {
+    std::array<std::any, 3> row = {std::any(value), std::any(value % 7), std::any()};
+    return create_row<int, int, double>(row);
+}
+
+TEST(ShardedRowSetTest, ShardsFilledConcurrently) {
+    // one thread per shard, each inserting only the rows of its shard
+    constexpr int VALUE_COUNT = 20000;
+    ShardedRowSet<int, int, double> rows(3);
+    ASSERT_EQ(rows.shard_count(), 8);
+    std::vector<std::thread> threads;
+    for (std::size_t shard = 0; shard < rows.shard_count(); shard++) {
+        threads.emplace_back([&rows, shard]() {
+            for (int value = 0; value < VALUE_COUNT; value++) {
+                HashableRow<int, int, double> row = sharded_test_row(value);
+                if (rows.shard_of(row.hash) == shard) {
+                    rows.shard(shard).insert(row);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(rows.size(), VALUE_COUNT);
+    std::vector<int> seen(VALUE_COUNT, 0);
+    for (const auto& row : rows) {
+        seen[row.get<0>()]++;
+    }
+    for (int value = 0; value < VALUE_COUNT; value++) {
+        EXPECT_EQ(seen[value], 1);
+        EXPECT_TRUE(rows.contains(sharded_test_row(value)));
+    }
+    EXPECT_FALSE(rows.insert(sharded_test_row(0)).second);
+}
+
+TEST(ShardedRowSetTest, EqualAcrossShardCounts) {
+    Table<int, int, double> table{RowSet<int, int, double>(), std::bitset<3>("011")};
+    ShardedTable<int, int, double> sharded_table{ShardedRowSet<int, int, double>(4), std::bitset<3>("011")};
+    for (int value = 0; value < 1000; value++) {
+        table.data.insert(sharded_test_row(value));
+        sharded_table.data.insert(sharded_test_row(value));
+    }
+    ShardedRowSet<int, int, double> single_shard(table.data);
+    EXPECT_EQ(single_shard.shard_count(), 1);
+    EXPECT_EQ(single_shard, sharded_table.data);
+    EXPECT_EQ(content_hash(sharded_table), content_hash(table));
+
+    // empty shards are skipped when iterating
+    ShardedRowSet<int, int, double> sparse(4);
+    EXPECT_TRUE(sparse.begin() == sparse.end());
+    sparse.insert(sharded_test_row(1));
+    EXPECT_EQ(std::distance(sparse.begin(), sparse.end()), 1);
+    EXPECT_NE(sparse, single_shard);
+
+    // operators read the sharded backend
+    EXPECT_EQ(project(sharded_table, std::bitset<3>("010")).data, project(table, std::bitset<3>("010")).data);
+    Table<int, int, double> copied{RowSet<int, int, double>(), table.attributes};
+    inplace_union(copied, sharded_table);
+    EXPECT_EQ(copied.data, table.data);
+}
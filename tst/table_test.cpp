@@ -4,6 +4,7 @@
 #include <bitset>
 #include <any>
 #include <cmath>
+#include <memory_resource>
 
 #include "src/model/table.h"
 #include "src/model/row.h"
@@ -22,7 +23,7 @@ void verify_projection(
     
     // Verify that each row in the original table has a corresponding projection in the projected table
     for (const auto& original_row : original.data) {
-        auto expected_proj = create_projection<GlobalSchema...>(original_row.data, proj_attrs);
+        auto expected_proj = create_projection<GlobalSchema...>(original_row, proj_attrs);
         EXPECT_TRUE(projected.data.count(expected_proj) > 0) 
             << "Expected projection not found in projected table";
     }
@@ -48,8 +49,8 @@ void verify_dictionary_construction(
     // 1. Its X projection exists as a key in the construction map
     // 2. Its Y projection exists in the corresponding value set
     for (const auto& original_row : original_table.data) {
-        auto x_proj = create_projection<GlobalSchema...>(original_row.data, attrs_X);
-        auto y_proj = create_projection<GlobalSchema...>(original_row.data, attrs_Y);
+        auto x_proj = create_projection<GlobalSchema...>(original_row, attrs_X);
+        auto y_proj = create_projection<GlobalSchema...>(original_row, attrs_Y);
         
         EXPECT_TRUE(dict.construction_map.count(x_proj) > 0) 
             << "Failed to find X projection in construction map";
@@ -72,7 +73,7 @@ void verify_join_result(
     // Calculate expected number of rows by summing up Y values for each matching X
     size_t expected_size = 0;
     for (const auto& original_row : original_table.data) {
-        auto x_proj = create_projection<GlobalSchema...>(original_row.data, dict.attributes_X);
+        auto x_proj = create_projection<GlobalSchema...>(original_row, dict.attributes_X);
         if (dict.construction_map.count(x_proj) > 0) {
             expected_size += dict.construction_map.at(x_proj).size();
         }
@@ -82,13 +83,13 @@ void verify_join_result(
     
     // For each row in the joined table, verify its components
     for (const auto& joined_row : joined.data) {
-        auto x_proj = create_projection<GlobalSchema...>(joined_row.data, dict.attributes_X);
-        auto y_proj = create_projection<GlobalSchema...>(joined_row.data, dict.attributes_Y);
+        auto x_proj = create_projection<GlobalSchema...>(joined_row, dict.attributes_X);
+        auto y_proj = create_projection<GlobalSchema...>(joined_row, dict.attributes_Y);
         
         // Verify X projection exists in original table
         bool found_in_original = false;
         for (const auto& original_row : original_table.data) {
-            auto original_x_proj = create_projection<GlobalSchema...>(original_row.data, dict.attributes_X);
+            auto original_x_proj = create_projection<GlobalSchema...>(original_row, dict.attributes_X);
             if (x_proj == original_x_proj) {
                 found_in_original = true;
                 break;
@@ -163,7 +164,7 @@ void verify_partition_result(
 }
 
 TEST(TableTest, ProjectFirstTwoColumnsTest) {
-    std::unordered_set<HashableRow<int, double, double>> data;
+    RowSet<int, double, double> data;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -179,7 +180,7 @@ TEST(TableTest, ProjectFirstTwoColumnsTest) {
 }
 
 TEST(TableTest, ProjectSingleColumnTest) {
-    std::unordered_set<HashableRow<int, double, double>> data;
+    RowSet<int, double, double> data;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -195,7 +196,7 @@ TEST(TableTest, ProjectSingleColumnTest) {
 }
 
 TEST(TableTest, BasicConstructionTest) {
-    std::unordered_set<HashableRow<int, double, double>> data;
+    RowSet<int, double, double> data;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -213,7 +214,7 @@ TEST(TableTest, BasicConstructionTest) {
 }
 
 TEST(TableTest, OverlappingConstructionTest) {
-    std::unordered_set<HashableRow<int, double, double>> data;
+    RowSet<int, double, double> data;
     std::array<std::any, 3> row1 = {
         std::any((int) 5),
         std::any((double) 2.5),
@@ -235,7 +236,7 @@ TEST(TableTest, OverlappingConstructionTest) {
 }
 
 TEST(TableTest, BasicJoinTest) {
-    std::unordered_set<HashableRow<int, double, double>> data1;
+    RowSet<int, double, double> data1;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -246,7 +247,7 @@ TEST(TableTest, BasicJoinTest) {
     }
     Table<int, double, double> table1{data1, std::bitset<3>("011")};
     
-    std::unordered_map<HashableRow<int, double, double>, std::unordered_set<HashableRow<int, double, double>>> map;
+    RowMap<int, double, double> map;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> key = {
             std::any((int) i),
@@ -254,7 +255,7 @@ TEST(TableTest, BasicJoinTest) {
             std::any()
         };
         auto key_row = create_row<int, double, double>(key);
-        map[key_row] = std::unordered_set<HashableRow<int, double, double>>();
+        map[key_row] = RowSet<int, double, double>();
 
         std::array<std::any, 3> value = {
             std::any(),
@@ -270,7 +271,7 @@ TEST(TableTest, BasicJoinTest) {
 }
 
 TEST(TableTest, MultipleYJoinTest) {
-    std::unordered_set<HashableRow<int, double, double>> data1;
+    RowSet<int, double, double> data1;
     for (std::size_t i = 0; i < 2; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i),
@@ -281,7 +282,7 @@ TEST(TableTest, MultipleYJoinTest) {
     }
     Table<int, double, double> table1{data1, std::bitset<3>("011")};
     
-    std::unordered_map<HashableRow<int, double, double>, std::unordered_set<HashableRow<int, double, double>>> map;
+    RowMap<int, double, double> map;
     for (std::size_t i = 0; i < 2; i++) {
         std::array<std::any, 3> key = {
             std::any((int) i),
@@ -289,7 +290,7 @@ TEST(TableTest, MultipleYJoinTest) {
             std::any()
         };
         auto key_row = create_row<int, double, double>(key);
-        map[key_row] = std::unordered_set<HashableRow<int, double, double>>();
+        map[key_row] = RowSet<int, double, double>();
         
         for (std::size_t j = 0; j < 3; j++) {
             std::array<std::any, 3> value = {
@@ -307,7 +308,7 @@ TEST(TableTest, MultipleYJoinTest) {
 }
 
 TEST(TableTest, ExtensionTest) {
-    std::unordered_map<HashableRow<int, double, double>, std::unordered_set<HashableRow<int, double, double>>> map;
+    RowMap<int, double, double> map;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> key = {
             std::any((int) i),
@@ -330,7 +331,7 @@ TEST(TableTest, ExtensionTest) {
 }
 
 TEST(TableTest, EmptyTableTest) {
-    std::unordered_set<HashableRow<int, double, double>> empty_data;
+    RowSet<int, double, double> empty_data;
     Table<int, double, double> empty_table{empty_data, std::bitset<3>("111")};
     Table<int, double, double> empty_proj = project(empty_table, std::bitset<3>("011"));
     EXPECT_EQ(empty_proj.data.size(), 0);
@@ -339,7 +340,7 @@ TEST(TableTest, EmptyTableTest) {
 }
 
 TEST(TableTest, BasicPartitionTest) {
-    std::unordered_set<HashableRow<int, double, double>> data;
+    RowSet<int, double, double> data;
     for (std::size_t i = 0; i < 3; i++) {
         std::array<std::any, 3> row = {
             std::any((int) i % 2),
@@ -355,7 +356,7 @@ TEST(TableTest, BasicPartitionTest) {
 }
 
 TEST(TableTest, MultiColumnPartitionTest) {
-    std::unordered_set<HashableRow<int, double, double>> data;
+    RowSet<int, double, double> data;
     for (std::size_t i = 0; i < 3; i++) {
         for (std::size_t j = 0; j < 3; j++) {
             if (i == 0 && (j == 0 || j == 1)) {
@@ -383,3 +384,228 @@ TEST(TableTest, MultiColumnPartitionTest) {
     auto partitions = partition(table, std::bitset<3>("011"));
     verify_partition_result(table, partitions, std::bitset<3>("011"));
 } 
+
+// memory resource counting the allocations made through it
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        allocations++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST(TableTest, MemoryResourceTest) {
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 8; i++) {
+        std::array<std::any, 3> row = {
+            std::any((int) i % 2),
+            std::any((double) 2.0 * i),
+            std::any((double) 3.0 * i)
+        };
+        data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> table{data, std::bitset<3>("111")};
+
+    CountingResource resource;
+    Table<int, double, double> proj = project(table, std::bitset<3>("011"), &resource);
+    EXPECT_EQ(proj.data.get_allocator().resource(), &resource);
+    std::size_t proj_allocations = resource.allocations;
+    EXPECT_GT(proj_allocations, 0);
+
+    Dictionary<int, double, double> dict = construction(table, std::bitset<3>("001"), std::bitset<3>("110"), &resource);
+    EXPECT_GT(resource.allocations, proj_allocations);
+    Table<int, double, double> joined = join(project(table, std::bitset<3>("001")), dict, &resource);
+    EXPECT_EQ(joined.data.get_allocator().resource(), &resource);
+    EXPECT_EQ(joined.data, table.data);
+
+    // copies are made on the default resource
+    Table<int, double, double> copied = proj;
+    EXPECT_EQ(copied.data.get_allocator().resource(), std::pmr::get_default_resource());
+}
+
+TEST(TableTest, PartitionEdgeCasesTest) {
+    RowSet<int, double, double> empty_data;
+    Table<int, double, double> empty_table{empty_data, std::bitset<3>("111")};
+    EXPECT_EQ(partition(empty_table, std::bitset<3>("001")).size(), 0);
+
+    RowSet<int, double, double> data;
+    std::array<std::any, 3> row = {std::any((int) 1), std::any((double) 2.0), std::any((double) 3.0)};
+    data.insert(create_row<int, double, double>(row));
+    Table<int, double, double> table{data, std::bitset<3>("111")};
+    auto partitions = partition(table, std::bitset<3>("001"));
+    ASSERT_EQ(partitions.size(), 1);
+    EXPECT_EQ(partitions[0].data, table.data);
+}
+
+TEST(TableTest, HeavyLightPartitionTest) {
+    // one heavy X value with 16 rows and 8 light X values with one row each
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 16; i++) {
+        std::array<std::any, 3> row = {std::any((int) 0), std::any((double) i), std::any()};
+        data.insert(create_row<int, double, double>(row));
+    }
+    for (std::size_t i = 1; i <= 8; i++) {
+        std::array<std::any, 3> row = {std::any((int) i), std::any((double) i), std::any()};
+        data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> table{data, std::bitset<3>("011")};
+
+    PartitionStrategy strategy;
+    strategy.mode = PartitionMode::HEAVY_LIGHT;
+    strategy.split_classes = false;
+    auto partitions = partition(table, std::bitset<3>("001"), strategy);
+    ASSERT_EQ(partitions.size(), 2);
+    EXPECT_EQ(partitions[0].data.size(), 8);
+    EXPECT_EQ(partitions[1].data.size(), 16);
+    verify_partition_result(table, partitions, std::bitset<3>("001"));
+}
+
+TEST(TableTest, CoalescedPartitionTest) {
+    // degrees 1, 2, 4 and 8 - one log-degree class each
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 4; i++) {
+        for (std::size_t j = 0; j < (1u << i); j++) {
+            std::array<std::any, 3> row = {std::any((int) i), std::any((double) j), std::any()};
+            data.insert(create_row<int, double, double>(row));
+        }
+    }
+    Table<int, double, double> table{data, std::bitset<3>("011")};
+    EXPECT_EQ(partition(table, std::bitset<3>("001")).size(), 7);
+
+    PartitionStrategy strategy;
+    strategy.coalesce_rows = 4;
+    strategy.split_classes = false;
+    auto partitions = partition(table, std::bitset<3>("001"), strategy);
+    // {1, 2, 4} reaches the threshold, {8} stands alone
+    ASSERT_EQ(partitions.size(), 2);
+    EXPECT_EQ(partitions[0].data.size(), 7);
+    EXPECT_EQ(partitions[1].data.size(), 8);
+
+    strategy.coalesce_rows = 0;
+    strategy.class_width = 2;
+    EXPECT_EQ(partition(table, std::bitset<3>("001"), strategy).size(), 2);
+}
+
+TEST(TableTest, IndexPartitionMatchesUnfusedTest) {
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 6; i++) {
+        for (std::size_t j = 0; j <= i; j++) {
+            std::array<std::any, 3> row = {std::any((int) i), std::any((double) j), std::any()};
+            data.insert(create_row<int, double, double>(row));
+        }
+    }
+    Table<int, double, double> table{data, std::bitset<3>("011")};
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+
+    // the unfused operators run over the rows of the same groups - a run split between two partitions may
+    // split differently on another grouping, since the split follows hash map iteration order
+    std::vector<std::vector<PartitionRun<int, double, double>>> groups = group_partitions(table, X, PartitionStrategy());
+    ASSERT_EQ(groups.size(), partition(table, X).size());
+    for (std::size_t i = 0; i < groups.size(); i++) {
+        Table<int, double, double> partitioned_table{RowSet<int, double, double>(), table.attributes};
+        for (const auto& run : groups[i]) {
+            for (const HashableRow<int, double, double>* row : run.rows) {
+                partitioned_table.data.insert(*row);
+            }
+        }
+        IndexedPartition<int, double, double> indexed = index_partition(groups[i], X, Y, Z);
+        Dictionary<int, double, double> expected_dict = extension(construction(partitioned_table, X, Y), Z);
+        EXPECT_EQ(indexed.table_X.data, project(partitioned_table, X).data);
+        EXPECT_TRUE(same_content(indexed.dict_Y_XZ, expected_dict));
+        EXPECT_EQ(indexed.degree, degree(expected_dict));
+    }
+}
+
+TEST(TableTest, ExtensionSharesConstructionMapTest) {
+    using Base = BaseDictionary<int, double, double>;
+    using Extended = ExtendedDictionary<int, double, double>;
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 4; i++) {
+        std::array<std::any, 3> row = {std::any((int) i), std::any((double) 2.0 * i), std::any()};
+        data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> table{data, std::bitset<3>("011")};
+    Dictionary<int, double, double> dict = construction(table, std::bitset<3>("001"), std::bitset<3>("010"));
+    Dictionary<int, double, double> ext = extension(dict, std::bitset<3>("000"));
+    Dictionary<int, double, double> ext_twice = extension(ext, std::bitset<3>("100"));
+
+    const auto& base_map = std::get<Base>(dict).construction_map;
+    EXPECT_TRUE(std::get<Extended>(ext).construction_map.shares_storage(base_map));
+    EXPECT_TRUE(std::get<Extended>(ext_twice).construction_map.shares_storage(base_map));
+    EXPECT_EQ(degree(ext_twice), degree(dict));
+
+    // the extension outlives the dictionary it was built from
+    dict = Dictionary<int, double, double>();
+    Table<int, double, double> joined = join(project(table, std::bitset<3>("001")), ext);
+    EXPECT_EQ(joined.data, table.data);
+
+    // arena storage is copied rather than shared, so extensions and copies outlive the arena
+    auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+    Dictionary<int, double, double> arena_dict = construction(table, std::bitset<3>("001"), std::bitset<3>("010"), arena.get());
+    Dictionary<int, double, double> arena_ext = extension(arena_dict, std::bitset<3>("000"));
+    Dictionary<int, double, double> arena_copy = arena_dict;
+    EXPECT_FALSE(std::get<Extended>(arena_ext).construction_map.shares_storage(std::get<Base>(arena_dict).construction_map));
+    EXPECT_FALSE(std::get<Base>(arena_copy).construction_map.shares_storage(std::get<Base>(arena_dict).construction_map));
+    Dictionary<int, double, double> same_arena_ext = extension(arena_dict, std::bitset<3>("000"), arena.get());
+    EXPECT_TRUE(std::get<Extended>(same_arena_ext).construction_map.shares_storage(std::get<Base>(arena_dict).construction_map));
+    same_arena_ext = Dictionary<int, double, double>();
+    arena_dict = Dictionary<int, double, double>();
+    arena.reset();
+    EXPECT_EQ(join(project(table, std::bitset<3>("001")), arena_ext).data, table.data);
+    EXPECT_EQ(join(project(table, std::bitset<3>("001")), arena_copy).data, table.data);
+}
+
+TEST(TableTest, RadixJoinMatchesDirectProbeTest) {
+    RowSet<int, double, double> data;
+    for (std::size_t i = 0; i < 512; i++) {
+        for (std::size_t j = 0; j < i % 3; j++) {
+            std::array<std::any, 3> row = {std::any((int) i), std::any((double) j), std::any()};
+            data.insert(create_row<int, double, double>(row));
+        }
+    }
+    Table<int, double, double> table{data, std::bitset<3>("011")};
+    BaseDictionary<int, double, double> dict = std::get<BaseDictionary<int, double, double>>(
+        construction(table, std::bitset<3>("001"), std::bitset<3>("010")));
+    // probe with every X value, including ones missing from the dictionary
+    RowSet<int, double, double> probe_data;
+    for (std::size_t i = 0; i < 600; i++) {
+        std::array<std::any, 3> row = {std::any((int) i), std::any(), std::any()};
+        probe_data.insert(create_row<int, double, double>(row));
+    }
+    Table<int, double, double> probe{probe_data, std::bitset<3>("001")};
+
+    Table<int, double, double> direct = join(probe, dict);
+    EXPECT_EQ(direct.data, table.data);
+    for (unsigned radix_bits : {1u, 4u, 8u}) {
+        Table<int, double, double> radix{RowSet<int, double, double>(), direct.attributes};
+        probe_join(probe, dict.construction_map, dict.attributes_X, dict.attributes_X, dict.attributes_Y, radix_bits, radix);
+        EXPECT_EQ(radix.data, direct.data);
+    }
+}
+
+TEST(TableTest, BatchedInsertTest) {
+    // more items than one batch, with duplicates
+    std::vector<int> values;
+    for (std::size_t i = 0; i < 3 * PROBE_BATCH_SIZE + 5; i++) {
+        values.push_back(i % 50);
+    }
+    RowSet<int, double, double> rows;
+    batched_insert(rows, values.begin(), values.end(), [](int value) {
+        std::array<std::any, 3> row = {std::any(value), std::any(), std::any()};
+        return create_row<int, double, double>(row);
+    });
+    EXPECT_EQ(rows.size(), 50);
+}
@@ -1,11 +1,35 @@
 #pragma once
 
+#include <any>
+
 #include "src/model/table.h"
 #include "src/model/row.h"
 
+template<std::size_t index, typename... GlobalSchema>
+elem_type<index, GlobalSchema...> any_value(const std::array<std::any, sizeof...(GlobalSchema)>& values) {
+    if (values[index].has_value()) {
+        return std::any_cast<elem_type<index, GlobalSchema...>>(values[index]);
+    } else {
+        return elem_type<index, GlobalSchema...>();
+    }
+}
+
+template<typename... GlobalSchema, std::size_t... Indices>
+HashableRow<GlobalSchema...> create_row_pack(
+    const std::array<std::any, sizeof...(GlobalSchema)>& values,
+    std::index_sequence<Indices...>) {
+
+    attr_type<GlobalSchema...> attrs;
+    for (std::size_t i = 0; i < sizeof...(GlobalSchema); i++) {
+        attrs[i] = values[i].has_value();
+    }
+    row_data_type<GlobalSchema...> data = {any_value<Indices, GlobalSchema...>(values)...};
+    return HashableRow<GlobalSchema...>(data, attrs);
+}
+
 template<typename... GlobalSchema>
 HashableRow<GlobalSchema...> create_row(const std::array<std::any, sizeof...(GlobalSchema)>& values) {
-    return HashableRow<GlobalSchema...>(values);
+    return create_row_pack<GlobalSchema...>(values, std::make_index_sequence<sizeof...(GlobalSchema)>{});
 }
 
 template<typename... GlobalSchema>
@@ -19,3 +43,11 @@ HashableRow<GlobalSchema...> create_projection(
     }
     return create_row<GlobalSchema...>(proj_arr);
 }
+
+template<typename... GlobalSchema>
+HashableRow<GlobalSchema...> create_projection(
+    const HashableRow<GlobalSchema...>& row,
+    const attr_type<GlobalSchema...>& attrs) {
+
+    return HashableRow<GlobalSchema...>(row.data, row.attributes & attrs);
+}
@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+
+#include "src/thread_pool.h"
+
+TEST(WorkStealingPoolTest, NestedTasks) {
+    WorkStealingPool pool(4);
+    std::atomic<std::size_t> visited{0};
+
+    // binary tree of depth 10 - every task submits its children to its own worker
+    std::function<void(std::size_t, std::size_t)> visit = [&](std::size_t depth, std::size_t worker) {
+        visited++;
+        if (depth < 10) {
+            for (int child = 0; child < 2; child++) {
+                pool.submit([&visit, depth](std::size_t child_worker) { visit(depth + 1, child_worker); }, worker);
+            }
+        }
+    };
+    pool.submit([&visit](std::size_t worker) { visit(0, worker); });
+    pool.wait();
+    EXPECT_EQ(visited, (1u << 11) - 1);
+
+    // the pool can be reused once drained
+    pool.submit([&visited](std::size_t) { visited++; });
+    pool.wait();
+    EXPECT_EQ(visited, 1u << 11);
+}
+
+TEST(WorkStealingPoolTest, RethrowsTaskException) {
+    WorkStealingPool pool(2);
+    pool.submit([](std::size_t) { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <unordered_map>
+#include <vector>
+
+#include "src/model/panda.h"
+#include "src/model/witness_map.h"
+
+TEST(WitnessMapTest, IndexesFollowCounts) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Monotonicity<int, double, double> mon_XY = {X ^ Y, NULL_ATTR<int, double, double>};
+    Monotonicity<int, double, double> mon_Y_X = {Y, X};
+    Monotonicity<int, double, double> mon_Z_X = {Z, X};
+
+    std::unordered_map<Monotonicity<int, double, double>, unsigned> counts = {{mon_XY, 1}, {mon_Y_X, 2}};
+    WitnessMap<Monotonicity<int, double, double>> D = counts;
+    std::vector<Monotonicity<int, double, double>> unconditional = {mon_XY};
+    std::vector<Monotonicity<int, double, double>> conditioned_on_X = {mon_Y_X};
+    EXPECT_EQ(D.by_X(NULL_ATTR<int, double, double>), unconditional);
+    EXPECT_EQ(D.by_X(X), conditioned_on_X);
+    EXPECT_EQ(D.by_XY(X ^ Y).size(), 2);
+
+    // terms stay indexed until their count reaches zero
+    D.decrement(mon_Y_X);
+    EXPECT_EQ(D.by_X(X), conditioned_on_X);
+    D.decrement(mon_Y_X);
+    EXPECT_TRUE(D.by_X(X).empty());
+    EXPECT_EQ(D.count(mon_Y_X), 0);
+
+    D.increment(mon_Z_X);
+    std::vector<Monotonicity<int, double, double>> conditioned_on_X_after = {mon_Z_X};
+    EXPECT_EQ(D.by_X(X), conditioned_on_X_after);
+    EXPECT_EQ(D.by_XY(X ^ Z), conditioned_on_X_after);
+    EXPECT_EQ(D.at(mon_Z_X), 1);
+
+    // decrementing an absent term leaves the map unchanged
+    D.decrement(mon_Y_X);
+    EXPECT_EQ(D.size(), 2);
+}
+
+TEST(WitnessMapTest, SubmodularityIndex) {
+    attr_type<int, double, double> X = std::bitset<3>("001");
+    attr_type<int, double, double> Y = std::bitset<3>("010");
+    attr_type<int, double, double> Z = std::bitset<3>("100");
+    Submodularity<int, double, double> sub_YZ_X = {Y, Z, X};
+
+    WitnessMap<Submodularity<int, double, double>> S = {{sub_YZ_X, 1}};
+    std::vector<Submodularity<int, double, double>> expected = {sub_YZ_X};
+    EXPECT_EQ(S.by_XY(X ^ Y), expected);
+    EXPECT_TRUE(S.by_XY(X ^ Z).empty());
+}